@@ -12,25 +12,30 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 TARGET = MarketPlayer
 TEMPLATE = app
 
+include(model/model.pri)
+
 INCLUDEPATH += model
 INCLUDEPATH += plot
 INCLUDEPATH += appstate
 
 SOURCES += main.cpp\
         mainwindow.cpp \
-    model/model.cpp \
     plot/qcustomplot.cpp \
     plot/datatimeplot.cpp \
     plot/plotutils.cpp \
+    plot/plotrefreshscheduler.cpp \
+    plot/minmaxpyramid.cpp \
+    plot/edgeworthcurves.cpp \
     plot/datatimeratioplot.cpp \
     plot/distributionplot.cpp \
     plot/plot.cpp \
-    model/modelutils.cpp \
     simulationcase.cpp \
     colormanager.cpp \
     casenamemanager.cpp \
-    model/strategy.cpp \
     strategymapper.cpp \
+    simulationconfig.cpp \
+    checkpoint.cpp \
+    sweep.cpp \
     plot/plottablebundle.cpp \
     plot/datatimeplottablebundle.cpp \
     plot/distributionplottablebundle.cpp \
@@ -40,22 +45,26 @@ SOURCES += main.cpp\
     appstate/appstate.cpp \
     appstate/appwaitingforsimulationloaded.cpp \
     appstate/appinsimulationmode.cpp \
-    appstate/appincomparisonmode.cpp
+    appstate/appincomparisonmode.cpp \
+    simulationworker.cpp
 
 HEADERS  += mainwindow.h \
-    model/model.h \
     plot/qcustomplot.h \
     plot/datatimeplot.h \
     plot/plotutils.h \
+    plot/plotrefreshscheduler.h \
+    plot/minmaxpyramid.h \
+    plot/edgeworthcurves.h \
     plot/datatimeratioplot.h \
     plot/distributionplot.h \
     plot/plot.h \
-    model/modelutils.h \
     simulationcase.h \
     colormanager.h \
     casenamemanager.h \
-    model/strategy.h \
     strategymapper.h \
+    simulationconfig.h \
+    checkpoint.h \
+    sweep.h \
     plot/plottablebundle.h \
     plot/datatimeplottablebundle.h \
     plot/distributionplottablebundle.h \
@@ -66,6 +75,7 @@ HEADERS  += mainwindow.h \
     appstate/appwaitingforsimulationloaded.h \
     appstate/appinsimulationmode.h \
     appstate/appincomparisonmode.h \
-    appstate/apphavingsimulationloaded.h
+    appstate/apphavingsimulationloaded.h \
+    simulationworker.h
 
 FORMS    += mainwindow.ui
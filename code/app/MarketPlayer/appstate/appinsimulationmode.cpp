@@ -14,6 +14,7 @@ void AppInSimulationMode::enter()
          mainWindow->ui->actionNextTrade,
          mainWindow->ui->actionStart,
          mainWindow->ui->actionSaveConfiguration,
+         mainWindow->ui->actionSaveCheckpoint,
          mainWindow->ui->actionSaveEdgeworthDiagram
         })
     {
@@ -1,5 +1,6 @@
 #include "casemanager.h"
 #include <algorithm>
+#include <utility>
 
 CaseManager::CaseManager(
         DataTimeRatioPlot* plotQ1Traded,
@@ -7,26 +8,87 @@ CaseManager::CaseManager(
         DataTimePlot* plotSumUtility,
         DataTimeRatioPlot* plotNumSuccessfulTrades,
         DataTimePlot* plotWealthDeviation,
+        DataTimePlot* plotWealthGini,
+        DataTimePlot* plotWealthTopShare,
+        DataTimePlot* plotWealthP10,
+        DataTimePlot* plotWealthP50,
+        DataTimePlot* plotWealthP90,
+        DataTimePlot* plotWealthP99,
         DistributionPlot* plotQ1Distribution,
         DistributionPlot* plotQ2Distribution,
         DistributionPlot* plotUtilityDistribution,
-        DistributionPlot* plotWealthDistribution
+        DistributionPlot* plotWealthDistribution,
+        PlotRefreshScheduler* refreshScheduler
         )
     :   plotQ1Traded(plotQ1Traded)
     ,   plotQ2Traded(plotQ2Traded)
     ,   plotSumUtility(plotSumUtility)
     ,   plotNumSuccessfulTrades(plotNumSuccessfulTrades)
     ,   plotWealthDeviation(plotWealthDeviation)
+    ,   plotWealthGini(plotWealthGini)
+    ,   plotWealthTopShare(plotWealthTopShare)
+    ,   plotWealthP10(plotWealthP10)
+    ,   plotWealthP50(plotWealthP50)
+    ,   plotWealthP90(plotWealthP90)
+    ,   plotWealthP99(plotWealthP99)
     ,   plotQ1Distribution(plotQ1Distribution)
     ,   plotQ2Distribution(plotQ2Distribution)
     ,   plotUtilityDistribution(plotUtilityDistribution)
     ,   plotWealthDistribution(plotWealthDistribution)
-    ,   dataTimePlots({plotQ1Traded, plotQ2Traded, plotSumUtility, plotNumSuccessfulTrades, plotWealthDeviation})
+    ,   dataTimePlots({plotQ1Traded, plotQ2Traded, plotSumUtility, plotNumSuccessfulTrades, plotWealthDeviation,
+                       plotWealthGini, plotWealthTopShare, plotWealthP10, plotWealthP50, plotWealthP90, plotWealthP99})
     ,   distributionPlots({plotQ1Distribution, plotQ2Distribution, plotUtilityDistribution, plotWealthDistribution})
+    ,   refreshScheduler(refreshScheduler)
     ,   currentDataIdx(0)
 {
     plots.insert(plots.end(), dataTimePlots.begin(), dataTimePlots.end());
     plots.insert(plots.end(), distributionPlots.begin(), distributionPlots.end());
+
+    typedef DataTimePlottableBundle TimeBundle;
+    typedef DataTimeRatioPlottableBundle RatioBundle;
+    typedef DistributionPlottableBundle DistributionBundle;
+    registerPlot(plotSumUtility, [](TimeBundle& bundle, Simulation const& simulation, int dataIdx) {
+        bundle.updateData(simulation.history.sumUtilities, dataIdx);
+    });
+    registerPlot(plotWealthDeviation, [](TimeBundle& bundle, Simulation const& simulation, int dataIdx) {
+        bundle.updateData(simulation.history.wealthDeviation, dataIdx);
+    });
+    //the inequality plots differ only in their series
+    std::pair<DataTimePlot*, DataTimePair History::*> const inequalityPlots[] = {
+        {plotWealthGini, &History::wealthGini},
+        {plotWealthTopShare, &History::wealthTopShare},
+        {plotWealthP10, &History::wealthP10},
+        {plotWealthP50, &History::wealthP50},
+        {plotWealthP90, &History::wealthP90},
+        {plotWealthP99, &History::wealthP99}
+    };
+    for (auto const& plotSeries : inequalityPlots) {
+        auto const series = plotSeries.second;
+        registerPlot(plotSeries.first, [series](TimeBundle& bundle, Simulation const& simulation, int dataIdx) {
+            bundle.updateData(simulation.history.*series, dataIdx);
+        });
+    }
+    registerPlot(plotQ1Traded, [](RatioBundle& bundle, Simulation const& simulation, int dataIdx) {
+        bundle.updateData(simulation.history.q1Traded, dataIdx, simulation.getSumQ1());
+    });
+    registerPlot(plotQ2Traded, [](RatioBundle& bundle, Simulation const& simulation, int dataIdx) {
+        bundle.updateData(simulation.history.q2Traded, dataIdx, simulation.getSumQ2());
+    });
+    registerPlot(plotNumSuccessfulTrades, [](RatioBundle& bundle, Simulation const& simulation, int dataIdx) {
+        bundle.updateData(simulation.history.numSuccessful, dataIdx, simulation.getNumMaxTrade());
+    });
+    registerPlot(plotQ1Distribution, [](DistributionBundle& bundle, Simulation const& simulation, int dataIdx) {
+        bundle.updateData(simulation.history.moments[dataIdx].q1Distribution);
+    });
+    registerPlot(plotQ2Distribution, [](DistributionBundle& bundle, Simulation const& simulation, int dataIdx) {
+        bundle.updateData(simulation.history.moments[dataIdx].q2Distribution);
+    });
+    registerPlot(plotUtilityDistribution, [](DistributionBundle& bundle, Simulation const& simulation, int dataIdx) {
+        bundle.updateData(simulation.history.moments[dataIdx].utilityDistribution);
+    });
+    registerPlot(plotWealthDistribution, [](DistributionBundle& bundle, Simulation const& simulation, int dataIdx) {
+        bundle.updateData(simulation.history.moments[dataIdx].wealthDistribution);
+    });
 }
 
 bool CaseManager::contains(QString caseName) const
@@ -59,13 +121,13 @@ size_t CaseManager::getValidCurrentDataIdx() const
     return currentDataIdx;
 }
 
-void CaseManager::addHeavyCase(QString caseName, const Simulation &simulation, QColor color, bool visible)
+void CaseManager::addHeavyCase(QString caseName, const SimulationSnapshot &simulation, QColor color, bool visible)
 {
     addCase<HeavySimulationCase>(simulation, caseName, color, visible);
 }
 
-//The caller has to ensure the passed simulation outlives the manager
-void CaseManager::addExternalCase(QString caseName, const Simulation &simulation, QColor color, bool visible)
+//The caller has to ensure the passed pointer outlives the manager, the case follows what it is set to
+void CaseManager::addExternalCase(QString caseName, const SimulationSnapshot &simulation, QColor color, bool visible)
 {
     addCase<ExternalSimulationCase>(simulation, caseName, color, visible);
 }
@@ -78,6 +140,7 @@ void CaseManager::removeCase(QString caseName)
         dropBundles(*simulationCase);
     }
     simulationCases.erase(foundElement);
+    ensembles.erase(caseName);
     updatePlots();
 }
 
@@ -99,16 +162,8 @@ void CaseManager::updatePlotsAt(int dataIdx)
 {
     currentDataIdx = dataIdx;
     validateCurrentDataIdx();
-    updateSingleCaseDataIfShown(*simulationCases.begin()->second, dataIdx);
-    for (auto& oneCase : simulationCases) {
-        auto& simulationCase = oneCase.second;
-        updateSingleCaseDataIfShown(*simulationCase, dataIdx);
-    }
-    for (auto& dataTimePlot : dataTimePlots) {
-        dataTimePlot->update();
-    }
-    for (auto& distributionPlot : distributionPlots) {
-        distributionPlot->update();
+    for (auto& plot : plots) {
+        refreshScheduler->markDirty(plot->getCustomPlot());
     }
 }
 
@@ -117,6 +172,16 @@ void CaseManager::updatePlots()
     updatePlotsAt(currentDataIdx);
 }
 
+void CaseManager::resetPlotData(QString caseName)
+{
+    if (contains(caseName) && simulationCases[caseName]->isShown) {
+        for (auto& dataTimePlot : dataTimePlots) {
+            dataTimePlot->provideBundle(caseName)->resetData();
+        }
+        updatePlots();
+    }
+}
+
 void CaseManager::hideAllCases()
 {
     for (auto& oneCase : simulationCases) {
@@ -124,6 +189,25 @@ void CaseManager::hideAllCases()
     }
 }
 
+void CaseManager::setEnsemble(QString caseName, std::shared_ptr<const Ensemble> ensemble)
+{
+    if (ensemble) {
+        ensembles[caseName] = ensemble;
+    } else {
+        ensembles.erase(caseName);
+    }
+    if (contains(caseName) && simulationCases[caseName]->isShown) {
+        setupBands(*simulationCases[caseName]);
+        updatePlots();
+    }
+}
+
+std::shared_ptr<const Ensemble> CaseManager::getEnsemble(QString caseName) const
+{
+    auto const foundElement = ensembles.find(caseName);
+    return foundElement != ensembles.end() ? foundElement->second : nullptr;
+}
+
 void CaseManager::setupBundles(const AbstractSimulationCase& simulationCase)
 {
     for (auto& dataTimePlot : dataTimePlots) {
@@ -132,6 +216,28 @@ void CaseManager::setupBundles(const AbstractSimulationCase& simulationCase)
     for (auto& distributionPlot : distributionPlots) {
         distributionPlot->provideBundle(simulationCase.caseName)->setColor(simulationCase.color);
     }
+    setupBands(simulationCase);
+}
+
+//The bands are fixed, so they are computed when the bundles are set up instead of on every update
+void CaseManager::setupBands(const AbstractSimulationCase &simulationCase)
+{
+    auto const ensemble = getEnsemble(simulationCase.caseName);
+    auto const caseName = simulationCase.caseName;
+    auto const calculateBand = [&ensemble](Ensemble::Series series) {
+        return ensemble ? ensemble->calculateBand(series) : EnsembleBand();
+    };
+    plotSumUtility->provideBundle(caseName)->setBand(calculateBand(Ensemble::SumUtilities));
+    plotWealthDeviation->provideBundle(caseName)->setBand(calculateBand(Ensemble::WealthDeviation));
+    plotWealthGini->provideBundle(caseName)->setBand(calculateBand(Ensemble::WealthGini));
+    plotWealthTopShare->provideBundle(caseName)->setBand(calculateBand(Ensemble::WealthTopShare));
+    plotWealthP10->provideBundle(caseName)->setBand(calculateBand(Ensemble::WealthP10));
+    plotWealthP50->provideBundle(caseName)->setBand(calculateBand(Ensemble::WealthP50));
+    plotWealthP90->provideBundle(caseName)->setBand(calculateBand(Ensemble::WealthP90));
+    plotWealthP99->provideBundle(caseName)->setBand(calculateBand(Ensemble::WealthP99));
+    plotQ1Traded->provideBundle(caseName)->setBand(calculateBand(Ensemble::Q1Traded));
+    plotQ2Traded->provideBundle(caseName)->setBand(calculateBand(Ensemble::Q2Traded));
+    plotNumSuccessfulTrades->provideBundle(caseName)->setBand(calculateBand(Ensemble::NumSuccessful));
 }
 
 void CaseManager::dropBundles(const AbstractSimulationCase &simulationCase)
@@ -144,31 +250,6 @@ void CaseManager::dropBundles(const AbstractSimulationCase &simulationCase)
     }
 }
 
-void CaseManager::updateSingleCaseDataIfShown(const AbstractSimulationCase &simulationCase, int dataIdx)
-{
-    if (simulationCase.isShown) {
-        auto const& simulation = simulationCase.getSimulation();
-        auto const& history = simulation.history;
-        if (dataIdx >= history.moments.size()) {
-            dataIdx = history.moments.size() - 1;
-        }
-        auto caseName = simulationCase.caseName;
-
-        plotSumUtility->provideBundle(caseName)->updateData(history.sumUtilities, dataIdx);
-        plotWealthDeviation->provideBundle(caseName)->updateData(history.wealthDeviation, dataIdx);
-
-        plotQ1Traded->provideBundle(caseName)->updateData(history.q1Traded, dataIdx, simulation.getSumQ1());
-        plotQ2Traded->provideBundle(caseName)->updateData(history.q2Traded, dataIdx, simulation.getSumQ2());
-        plotNumSuccessfulTrades->provideBundle(caseName)->updateData(history.numSuccessful, dataIdx, simulation.getNumMaxTrade());
-
-        auto const& moment = history.moments[dataIdx];
-        plotQ1Distribution->provideBundle(caseName)->updateData(moment.q1Distribution);
-        plotQ2Distribution->provideBundle(caseName)->updateData(moment.q2Distribution);
-        plotUtilityDistribution->provideBundle(caseName)->updateData(moment.utilityDistribution);
-        plotWealthDistribution->provideBundle(caseName)->updateData(moment.wealthDistribution);
-    }
-}
-
 void CaseManager::validateCurrentDataIdx()
 {
     auto const lastVisibleIdx = calculateLastVisibleDataIdx();
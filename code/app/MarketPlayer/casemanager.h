@@ -5,12 +5,15 @@
 #include <QString>
 #include <QColor>
 #include <vector>
+#include <memory>
 
 #include "model.h"
+#include "ensemble.h"
 #include "simulationcase.h"
 #include "datatimeplot.h"
 #include "datatimeratioplot.h"
 #include "distributionplot.h"
+#include "plotrefreshscheduler.h"
 
 struct CaseManager
 {
@@ -20,27 +23,41 @@ struct CaseManager
             DataTimePlot* plotSumUtility,
             DataTimeRatioPlot* plotNumSuccessfulTrades,
             DataTimePlot* plotWealthDeviation,
+            DataTimePlot* plotWealthGini,
+            DataTimePlot* plotWealthTopShare,
+            DataTimePlot* plotWealthP10,
+            DataTimePlot* plotWealthP50,
+            DataTimePlot* plotWealthP90,
+            DataTimePlot* plotWealthP99,
             DistributionPlot* plotQ1Distribution,
             DistributionPlot* plotQ2Distribution,
             DistributionPlot* plotUtilityDistribution,
-            DistributionPlot* plotWealthDistribution
+            DistributionPlot* plotWealthDistribution,
+            PlotRefreshScheduler* refreshScheduler
                 );
     bool contains(QString caseName) const;
     const AbstractSimulationCase &getSimulationCase(QString caseName) const;
     size_t calculateLastVisibleDataIdx() const;
     size_t getValidCurrentDataIdx() const;
 
-    void addHeavyCase(QString caseName, Simulation const& simulation, QColor color, bool visible);
-    void addExternalCase(QString caseName, Simulation const& simulation, QColor color, bool visible);
+    void addHeavyCase(QString caseName, SimulationSnapshot const& simulation, QColor color, bool visible);
+    void addExternalCase(QString caseName, SimulationSnapshot const& simulation, QColor color, bool visible);
     void removeCase(QString caseName);
     void setVisibility(QString caseName, bool visible);
+    //only marks the plots dirty, the scheduler pushes the data and replots the visible ones later
     void updatePlotsAt(int dataIdx);
     void updatePlots();
+    //the case's simulation was replaced, its series are pushed anew instead of appended
+    void resetPlotData(QString caseName);
     void hideAllCases();
 
+    //The ensemble run of a case's configuration, shown as bands around the series. Null removes it.
+    void setEnsemble(QString caseName, std::shared_ptr<Ensemble const> ensemble);
+    std::shared_ptr<Ensemble const> getEnsemble(QString caseName) const;
+
 private:
     template<class CaseType>
-    void addCase(Simulation const& simulation, QString caseName, QColor color, bool visible) {
+    void addCase(SimulationSnapshot const& simulation, QString caseName, QColor color, bool visible) {
         if (!contains(caseName)) {
             auto emplaceResult = simulationCases.emplace(caseName, unique_ptr<CaseType>(
                                         new CaseType(simulation, caseName, color, visible)));
@@ -54,16 +71,39 @@ private:
 
     void setupBundles(const AbstractSimulationCase& simulationCase);
     void dropBundles(const AbstractSimulationCase& simulationCase);
-    void updateSingleCaseDataIfShown(AbstractSimulationCase const& simulationCase, int dataIdx);
+    void setupBands(const AbstractSimulationCase& simulationCase);
+    //pushes every shown case into the plot at the current round, then updates the plot
+    template<class PlotType, class Push>
+    void registerPlot(PlotType* plot, Push push) {
+        refreshScheduler->addPlot(plot->getCustomPlot(), [this, plot, push]() {
+            for (auto const& oneCase : simulationCases) {
+                auto const& simulationCase = *oneCase.second;
+                if (simulationCase.isShown) {
+                    auto const& simulation = simulationCase.getSimulation();
+                    //dataIdx is a round, shown by the nearest round the history has retained
+                    int const dataIdx = simulation.history.findNearestIdx(currentDataIdx);
+                    push(*plot->provideBundle(simulationCase.caseName), simulation, dataIdx);
+                }
+            }
+            plot->update();
+        });
+    }
     void validateCurrentDataIdx();
 
     std::map<QString, unique_ptr<AbstractSimulationCase>> simulationCases;
+    std::map<QString, std::shared_ptr<Ensemble const>> ensembles;
 
     DataTimeRatioPlot* plotQ1Traded;
     DataTimeRatioPlot* plotQ2Traded;
     DataTimePlot* plotSumUtility;
     DataTimeRatioPlot* plotNumSuccessfulTrades;
     DataTimePlot* plotWealthDeviation;
+    DataTimePlot* plotWealthGini;
+    DataTimePlot* plotWealthTopShare;
+    DataTimePlot* plotWealthP10;
+    DataTimePlot* plotWealthP50;
+    DataTimePlot* plotWealthP90;
+    DataTimePlot* plotWealthP99;
 
     DistributionPlot* plotQ1Distribution;
     DistributionPlot* plotQ2Distribution;
@@ -73,6 +113,7 @@ private:
     std::vector<DataTimePlot*> dataTimePlots;
     std::vector<DistributionPlot*> distributionPlots;
     std::vector<Plot*> plots;
+    PlotRefreshScheduler* refreshScheduler;
 
     size_t currentDataIdx;
 };
@@ -0,0 +1,623 @@
+#include "checkpoint.h"
+#include "strategymapper.h"
+
+#include <QFile>
+#include <cstring>
+#include <limits>
+#include <string>
+
+//Layout, every value in the byte order of the writing machine (checked by the marker):
+//  header: magic, format version, byte order marker
+//  parameters, strategy names, round state, progress, actor columns,
+//  running distributions, history (series and moments)
+//Arrays are stored as their element count followed by the elements. The large ones
+//(actor columns, permutation) start on a 64 byte boundary of the file.
+namespace {
+
+char const checkpointMagic[8] = {'M', 'P', 'C', 'H', 'E', 'C', 'K', '\0'};
+//version 2 added the stopping criteria
+//version 3 added the histogram settings and the layouts of the distributions
+//version 4 added the bucket sums and the inequality series
+quint32 const checkpointVersion = 4;
+quint32 const byteOrderMarker = 0x01020304;
+size_t const arrayAlignment = 64;
+//writes are buffered up to this size, only the large arrays bypass the buffer
+size_t const writeBufferSize = 1 << 20;
+
+struct CheckpointWriter
+{
+    explicit CheckpointWriter(QFile& file)
+        : file(file)
+        , position(0)
+        , ok(true)
+    {}
+
+    template<typename T>
+    void write(T const& value) {
+        writeBytes(&value, sizeof(T));
+    }
+    void writeBytes(void const* data, size_t size) {
+        char const* bytes = static_cast<char const*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+        position += size;
+        if (buffer.size() >= writeBufferSize) {
+            flush();
+        }
+    }
+    void writeString(std::string const& value) {
+        write<quint64>(value.size());
+        writeBytes(value.data(), value.size());
+    }
+    template<typename T>
+    void writeArray(T const* data, size_t count) {
+        write<quint64>(count);
+        writeBytes(data, count * sizeof(T));
+    }
+    template<typename T>
+    void writeAlignedArray(T const* data, size_t count) {
+        write<quint64>(count);
+        while (position % arrayAlignment != 0) {
+            write<char>(0);
+        }
+        flush();
+        qint64 const size = count * sizeof(T);
+        ok = ok && file.write(reinterpret_cast<char const*>(data), size) == size;
+        position += size;
+    }
+    template<typename Series>
+    void writeSeries(Series const& series) {
+        write<quint64>(series.size());
+        for (size_t idx = 0; idx < series.size(); ++idx) {
+            write(series[idx]);
+        }
+    }
+    bool flush() {
+        if (!buffer.empty()) {
+            qint64 const size = buffer.size();
+            ok = ok && file.write(buffer.data(), size) == size;
+            buffer.clear();
+        }
+        return ok;
+    }
+
+    QFile& file;
+    std::vector<char> buffer;
+    size_t position;
+    bool ok;
+};
+
+//Reads from the mapped file. Every read is bounds checked: once one fails, all the following fail too.
+struct CheckpointReader
+{
+    CheckpointReader(uchar const* data, size_t size)
+        : data(data)
+        , size(size)
+        , position(0)
+        , ok(true)
+        , version(0)
+    {}
+
+    template<typename T>
+    bool read(T& value) {
+        return readBytes(&value, sizeof(T));
+    }
+    bool readBytes(void* target, size_t numBytes) {
+        ok = ok && numBytes <= size - position;
+        if (ok) {
+            std::memcpy(target, data + position, numBytes);
+            position += numBytes;
+        }
+        return ok;
+    }
+    bool readString(std::string& value) {
+        quint64 length = 0;
+        if (readCount(length, 1)) {
+            value.assign(reinterpret_cast<char const*>(data + position), length);
+            position += length;
+        }
+        return ok;
+    }
+    template<typename Container>
+    bool readArray(Container& target) {
+        typedef typename Container::value_type T;
+        quint64 count = 0;
+        if (readCount(count, sizeof(T))) {
+            target.resize(count);
+            readBytes(target.data(), count * sizeof(T));
+        }
+        return ok;
+    }
+    template<typename Container>
+    bool readAlignedArray(Container& target) {
+        typedef typename Container::value_type T;
+        quint64 count = 0;
+        read(count);
+        size_t const padding = (arrayAlignment - position % arrayAlignment) % arrayAlignment;
+        ok = ok && padding <= size - position;
+        position += ok ? padding : 0;
+        if (checkCount(count, sizeof(T))) {
+            target.resize(count);
+            readBytes(target.data(), count * sizeof(T));
+        }
+        return ok;
+    }
+    template<typename Series>
+    bool readSeries(Series& target) {
+        quint64 count = 0;
+        if (readCount(count, sizeof(Amount_t))) {
+            for (size_t idx = 0; idx < count; ++idx) {
+                Amount_t value;
+                read(value);
+                target.push_back(value);
+            }
+        }
+        return ok;
+    }
+
+    uchar const* data;
+    size_t size;
+    size_t position;
+    bool ok;
+    //of the file being read, known after the header
+    quint32 version;
+
+private:
+    bool readCount(quint64& count, size_t elementSize) {
+        read(count);
+        return checkCount(count, elementSize);
+    }
+    //the count must fit into the rest of the file, so a corrupt one can not trigger a huge allocation
+    bool checkCount(quint64 count, size_t elementSize) {
+        ok = ok && count <= (size - position) / elementSize;
+        return ok;
+    }
+};
+
+}
+
+struct CheckpointIo
+{
+    static void save(CheckpointWriter& out, Simulation const& simulation);
+    static bool load(CheckpointReader& in, Simulation& simulation, ActorStore& actors);
+
+private:
+    static void save(CheckpointWriter& out, Simulation::RoundInfo const& info);
+    static void save(CheckpointWriter& out, HistogramLayout const& layout);
+    static void save(CheckpointWriter& out, RunningDistribution const& distribution);
+    static void save(CheckpointWriter& out, HeavyDistribution const& distribution);
+    static void save(CheckpointWriter& out, DataTimePair const& series);
+    static void save(CheckpointWriter& out, History const& history);
+
+    static bool load(CheckpointReader& in, Simulation::RoundInfo& info);
+    static bool load(CheckpointReader& in, HistogramLayout& layout);
+    static bool load(CheckpointReader& in, RunningDistribution& distribution);
+    static bool load(CheckpointReader& in, HeavyDistribution& distribution);
+    static bool load(CheckpointReader& in, DataTimePair& series);
+    static bool load(CheckpointReader& in, History& history);
+};
+
+void CheckpointIo::save(CheckpointWriter& out, Simulation::RoundInfo const& info)
+{
+    out.write(info.q1Traded);
+    out.write(info.q2Traded);
+    out.write(info.numSuccessful);
+}
+
+bool CheckpointIo::load(CheckpointReader& in, Simulation::RoundInfo& info)
+{
+    in.read(info.q1Traded);
+    in.read(info.q2Traded);
+    return in.read(info.numSuccessful);
+}
+
+//Only the inputs of the factories are stored, so the derived members come out the same
+void CheckpointIo::save(CheckpointWriter& out, HistogramLayout const& layout)
+{
+    out.write<quint8>(layout.scale);
+    out.write(layout.resolution);
+    out.write(layout.firstEdge);
+    out.write(layout.lastEdge);
+    out.write<quint64>(layout.maxBuckets);
+}
+
+//Before version 3 the buckets were linear and unbounded
+bool CheckpointIo::load(CheckpointReader& in, HistogramLayout& layout)
+{
+    Amount_t resolution = 0.0;
+    if (in.version < 3) {
+        in.read(resolution);
+        layout = HistogramLayout::linear(resolution, std::numeric_limits<size_t>::max());
+        return in.ok;
+    }
+    quint8 scale = 0;
+    Amount_t firstEdge = 0.0, lastEdge = 0.0;
+    quint64 maxBuckets = 0;
+    in.read(scale);
+    in.read(resolution);
+    in.read(firstEdge);
+    in.read(lastEdge);
+    in.read(maxBuckets);
+    bool const isLog = scale == HistogramLayout::LogScale;
+    bool const valid = isLog ? firstEdge > 0 && lastEdge > firstEdge : scale == HistogramLayout::LinearScale && resolution > 0;
+    in.ok = in.ok && maxBuckets > 0 && valid;
+    if (in.ok) {
+        layout = isLog ?
+                    HistogramLayout::logarithmic(firstEdge, lastEdge, maxBuckets) :
+                    HistogramLayout::linear(resolution, maxBuckets);
+    }
+    return in.ok;
+}
+
+//The running sums are stored as they are instead of being recomputed,
+//so the resumed run carries the very same rounding as the saved one.
+void CheckpointIo::save(CheckpointWriter& out, RunningDistribution const& distribution)
+{
+    save(out, distribution.layout);
+    out.writeArray(distribution.centers.constData(), distribution.centers.size());
+    out.writeArray(distribution.counts.constData(), distribution.counts.size());
+    out.writeArray(distribution.sums.constData(), distribution.sums.size());
+    out.write<quint64>(distribution.count);
+    out.write(distribution.shift);
+    out.write(distribution.shiftedSum);
+    out.write(distribution.shiftedSquareSum);
+}
+
+bool CheckpointIo::load(CheckpointReader& in, RunningDistribution& distribution)
+{
+    quint64 count = 0;
+    load(in, distribution.layout);
+    in.readArray(distribution.centers);
+    in.readArray(distribution.counts);
+    //before version 4 the values are taken at the centers of their buckets until the next resync
+    if (in.version >= 4) {
+        in.readArray(distribution.sums);
+    } else {
+        distribution.sums = distribution.counts;
+        for (int idx = 0; idx < distribution.sums.size() && idx < distribution.centers.size(); ++idx) {
+            distribution.sums[idx] *= distribution.centers[idx];
+        }
+    }
+    in.ok = in.ok && distribution.sums.size() == distribution.counts.size();
+    in.read(count);
+    distribution.count = count;
+    in.read(distribution.shift);
+    in.read(distribution.shiftedSum);
+    return in.read(distribution.shiftedSquareSum);
+}
+
+void CheckpointIo::save(CheckpointWriter& out, HeavyDistribution const& distribution)
+{
+    save(out, distribution.layout);
+    out.write(distribution.maxSubject);
+    out.write(distribution.maxNum);
+    out.write<quint64>(distribution.numBuckets);
+    out.write(distribution.standardDeviation);
+    out.writeArray(distribution.data.x.constData(), distribution.data.x.size());
+    out.writeArray(distribution.data.y.constData(), distribution.data.y.size());
+}
+
+bool CheckpointIo::load(CheckpointReader& in, HeavyDistribution& distribution)
+{
+    quint64 numBuckets = 0;
+    load(in, distribution.layout);
+    in.read(distribution.maxSubject);
+    in.read(distribution.maxNum);
+    in.read(numBuckets);
+    distribution.numBuckets = numBuckets;
+    in.read(distribution.standardDeviation);
+    in.readArray(distribution.data.x);
+    return in.readArray(distribution.data.y);
+}
+
+void CheckpointIo::save(CheckpointWriter& out, DataTimePair const& series)
+{
+    out.write(series.max);
+    out.writeSeries(series.x);
+    out.writeSeries(series.y);
+}
+
+bool CheckpointIo::load(CheckpointReader& in, DataTimePair& series)
+{
+    series.reset();
+    in.read(series.max);
+    in.readSeries(series.x);
+    in.readSeries(series.y);
+    in.ok = in.ok && series.x.size() == series.y.size();
+    return in.ok;
+}
+
+void CheckpointIo::save(CheckpointWriter& out, History const& history)
+{
+    RetentionPolicy const& policy = history.retentionPolicy;
+    out.write<quint64>(policy.numRecentRounds);
+    out.write<quint64>(policy.tiers.size());
+    for (auto const& tier : policy.tiers) {
+        out.write<quint64>(tier.numRounds);
+        out.write<quint64>(tier.stride);
+    }
+    out.write<quint64>(policy.maxOldRounds);
+    out.write<quint64>(history.oldStride);
+    out.write<quint64>(history.time);
+
+    for (DataTimePair const* series : {&history.q1Traded, &history.q2Traded, &history.numSuccessful,
+                                       &history.sumUtilities, &history.wealthDeviation,
+                                       &history.wealthGini, &history.wealthP10, &history.wealthP50,
+                                       &history.wealthP90, &history.wealthP99, &history.wealthTopShare}) {
+        save(out, *series);
+    }
+
+    out.write<quint64>(history.moments.size());
+    for (size_t idx = 0; idx < history.moments.size(); ++idx) {
+        Moment const& moment = history.moments[idx];
+        out.write<quint64>(moment.time);
+        save(out, moment.q1Distribution);
+        save(out, moment.q2Distribution);
+        save(out, moment.utilityDistribution);
+        save(out, moment.wealthDistribution);
+    }
+}
+
+bool CheckpointIo::load(CheckpointReader& in, History& history)
+{
+    history.reset();
+    RetentionPolicy& policy = history.retentionPolicy;
+    quint64 numRecentRounds = 0, numTiers = 0, maxOldRounds = 0, oldStride = 0, time = 0;
+    in.read(numRecentRounds);
+    in.read(numTiers);
+    policy.tiers.clear();
+    for (quint64 tierIdx = 0; in.ok && tierIdx < numTiers; ++tierIdx) {
+        quint64 numRounds = 0, stride = 0;
+        in.read(numRounds);
+        in.read(stride);
+        policy.tiers.push_back(RetentionPolicy::Tier{static_cast<size_t>(numRounds), static_cast<size_t>(stride)});
+    }
+    in.read(maxOldRounds);
+    in.read(oldStride);
+    in.read(time);
+    policy.numRecentRounds = numRecentRounds;
+    policy.maxOldRounds = maxOldRounds;
+    history.oldStride = oldStride;
+    history.time = time;
+
+    for (DataTimePair* series : {&history.q1Traded, &history.q2Traded, &history.numSuccessful,
+                                 &history.sumUtilities, &history.wealthDeviation}) {
+        load(in, *series);
+    }
+    if (in.version >= 4) {
+        for (DataTimePair* series : {&history.wealthGini, &history.wealthP10, &history.wealthP50,
+                                     &history.wealthP90, &history.wealthP99, &history.wealthTopShare}) {
+            load(in, *series);
+        }
+    }
+
+    quint64 numMoments = 0;
+    in.read(numMoments);
+    //a set up simulation has at least the moment of round 0, the stopping rules start from the last one
+    in.ok = in.ok && numMoments > 0;
+    for (quint64 idx = 0; in.ok && idx < numMoments; ++idx) {
+        quint64 momentTime = 0;
+        in.read(momentTime);
+        Moment moment;
+        moment.time = momentTime;
+        load(in, moment.q1Distribution);
+        load(in, moment.q2Distribution);
+        load(in, moment.utilityDistribution);
+        load(in, moment.wealthDistribution);
+        history.moments.push_back(moment);
+        //before version 4 the inequality is estimated from the stored histograms
+        if (in.version < 4) {
+            HeavyDistribution const& wealth = moment.wealthDistribution;
+            vector<Amount_t> sums = wealth.data.y;
+            for (int bucketIdx = 0; bucketIdx < sums.size() && bucketIdx < wealth.data.x.size(); ++bucketIdx) {
+                sums[bucketIdx] *= wealth.data.x[bucketIdx];
+            }
+            history.pushInequality(moment.time, calculateInequality(wealth.layout, wealth.data.y, sums));
+        }
+    }
+    for (DataTimePair const* series : {&history.q1Traded, &history.q2Traded, &history.numSuccessful,
+                                       &history.sumUtilities, &history.wealthDeviation,
+                                       &history.wealthGini, &history.wealthP10, &history.wealthP50,
+                                       &history.wealthP90, &history.wealthP99, &history.wealthTopShare}) {
+        in.ok = in.ok && series->size() == history.moments.size();
+    }
+    return in.ok;
+}
+
+void CheckpointIo::save(CheckpointWriter& out, Simulation const& simulation)
+{
+    out.writeBytes(checkpointMagic, sizeof(checkpointMagic));
+    out.write(checkpointVersion);
+    out.write(byteOrderMarker);
+
+    out.write(simulation.seed);
+    out.write<quint64>(simulation.numActors);
+    out.writeArray(simulation.amounts.constData(), simulation.amounts.size());
+    out.write(simulation.utility.getAlfa1());
+    out.write(simulation.utility.getAlfa2());
+    out.write(simulation.minTradeFactor);
+    out.write<quint64>(simulation.maxRoundWithoutTrade);
+    out.write(simulation.minSumTrade);
+    out.write(simulation.q2Price);
+    out.write<quint64>(simulation.numThreads);
+    StoppingCriteria const& criteria = simulation.getStoppingCriteria();
+    out.write<quint64>(criteria.utilityWindow);
+    out.write(criteria.utilityEpsilon);
+    out.write<quint64>(criteria.volumeWindow);
+    out.write(criteria.volumeThreshold);
+    out.write<quint64>(criteria.maxRounds);
+    out.write(criteria.maxSeconds);
+    out.write<quint8>(criteria.requireAllConvergence);
+    HistogramSettings const& histogramSettings = simulation.getHistogramSettings();
+    out.write<quint8>(histogramSettings.scale);
+    out.write<quint64>(histogramSettings.maxBuckets);
+    OfferStrategyNameVisitor offerNameVisitor;
+    out.writeString(offerNameVisitor.getStrategyDescription(*simulation.offerStrategy).toStdString());
+    AcceptanceStrategyNameVisitor acceptanceNameVisitor;
+    out.writeString(acceptanceNameVisitor.getStrategyDescription(*simulation.acceptanceStrategy).toStdString());
+
+    save(out, simulation.roundInfo);
+    save(out, simulation.blockInfo);
+
+    //the shuffle and trade streams are keyed by the seed and the round, the rest of their state is the progress
+    Simulation::Progress const& progress = simulation.progress;
+    std::vector<quint64> const permutation(progress.permutation.begin(), progress.permutation.end());
+    out.writeAlignedArray(permutation.data(), permutation.size());
+    out.write<quint64>(progress.actIdx);
+    out.write<quint8>(progress.restarted);
+
+    out.writeAlignedArray(simulation.actors.q1.data(), simulation.actors.q1.size());
+    out.writeAlignedArray(simulation.actors.q2.data(), simulation.actors.q2.size());
+    out.writeAlignedArray(simulation.actors.utility.data(), simulation.actors.utility.size());
+
+    save(out, simulation.q1Distribution);
+    save(out, simulation.q2Distribution);
+    save(out, simulation.utilityDistribution);
+    save(out, simulation.wealthDistribution);
+
+    save(out, simulation.history);
+}
+
+//The actor columns are read into actors, so assigning the rest of the simulation does not copy them
+bool CheckpointIo::load(CheckpointReader& in, Simulation& simulation, ActorStore& actors)
+{
+    char magic[sizeof(checkpointMagic)];
+    quint32 version = 0, marker = 0;
+    in.readBytes(magic, sizeof(magic));
+    in.read(version);
+    in.read(marker);
+    if (!in.ok || std::memcmp(magic, checkpointMagic, sizeof(magic)) != 0 ||
+            version < 1 || version > checkpointVersion || marker != byteOrderMarker) {
+        return false;
+    }
+    in.version = version;
+
+    quint64 numActors = 0, maxRoundWithoutTrade = 0, numThreads = 0;
+    double alfa1 = 0.0, alfa2 = 0.0;
+    in.read(simulation.seed);
+    in.read(numActors);
+    simulation.numActors = numActors;
+    in.readArray(simulation.amounts);
+    in.read(alfa1);
+    in.read(alfa2);
+    simulation.utility = Utility(alfa1, alfa2);
+    in.read(simulation.minTradeFactor);
+    in.read(maxRoundWithoutTrade);
+    simulation.maxRoundWithoutTrade = maxRoundWithoutTrade;
+    in.read(simulation.minSumTrade);
+    in.read(simulation.q2Price);
+    in.read(numThreads);
+    StoppingCriteria criteria;
+    if (version >= 2) {
+        quint64 utilityWindow = 0, volumeWindow = 0, maxRounds = 0;
+        quint8 requireAllConvergence = 0;
+        in.read(utilityWindow);
+        in.read(criteria.utilityEpsilon);
+        in.read(volumeWindow);
+        in.read(criteria.volumeThreshold);
+        in.read(maxRounds);
+        in.read(criteria.maxSeconds);
+        in.read(requireAllConvergence);
+        criteria.utilityWindow = utilityWindow;
+        criteria.volumeWindow = volumeWindow;
+        criteria.maxRounds = maxRounds;
+        criteria.requireAllConvergence = requireAllConvergence != 0;
+    }
+    HistogramSettings histogramSettings;
+    if (version >= 3) {
+        quint8 scale = 0;
+        quint64 maxBuckets = 0;
+        in.read(scale);
+        in.read(maxBuckets);
+        in.ok = in.ok && scale <= HistogramLayout::LogScale && maxBuckets > 0;
+        histogramSettings.scale = static_cast<HistogramLayout::Scale>(scale);
+        histogramSettings.maxBuckets = maxBuckets;
+    }
+    simulation.setHistogramSettings(histogramSettings);
+    std::string offerStrategyName, acceptanceStrategyName;
+    in.readString(offerStrategyName);
+    in.readString(acceptanceStrategyName);
+    if (!in.ok || !isOfferStrategyName(QString::fromStdString(offerStrategyName)) ||
+            !isAcceptanceStrategyName(QString::fromStdString(acceptanceStrategyName))) {
+        return false;
+    }
+    simulation.setStrategies(createOfferStrategy(QString::fromStdString(offerStrategyName)),
+                             createAcceptanceStrategy(QString::fromStdString(acceptanceStrategyName)));
+    simulation.setNumThreads(numThreads);
+
+    load(in, simulation.roundInfo);
+    load(in, simulation.blockInfo);
+
+    Simulation::Progress& progress = simulation.progress;
+    std::vector<quint64> permutation;
+    quint64 actIdx = 0;
+    quint8 restarted = 0;
+    in.readAlignedArray(permutation);
+    in.read(actIdx);
+    in.read(restarted);
+    progress.permutation.resize(permutation.size());
+    std::copy(permutation.begin(), permutation.end(), progress.permutation.begin());
+    progress.actIdx = actIdx;
+    progress.restarted = restarted != 0;
+
+    in.readAlignedArray(actors.q1);
+    in.readAlignedArray(actors.q2);
+    in.readAlignedArray(actors.utility);
+
+    load(in, simulation.q1Distribution);
+    load(in, simulation.q2Distribution);
+    load(in, simulation.utilityDistribution);
+    load(in, simulation.wealthDistribution);
+
+    load(in, simulation.history);
+    //the rules take their state from the recent rounds of the history
+    if (in.ok && simulation.amounts.size() == 2) {
+        simulation.setStoppingCriteria(criteria);
+    }
+
+    return in.ok && in.position == in.size &&
+            simulation.offerStrategy.get() && simulation.acceptanceStrategy.get() &&
+            simulation.amounts.size() == 2 && simulation.getStoppingRule() &&
+            permutation.size() == numActors && actIdx <= numActors && actIdx % 2 == 0 &&
+            actors.q1.size() == numActors && actors.q2.size() == numActors && actors.utility.size() == numActors &&
+            std::all_of(permutation.begin(), permutation.end(), [numActors](quint64 idx) { return idx < numActors; });
+}
+
+bool saveCheckpoint(QString fileName, Simulation const& simulation)
+{
+    if (!simulation.offerStrategy.get() || !simulation.acceptanceStrategy.get()) {
+        return false;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    CheckpointWriter out(file);
+    CheckpointIo::save(out, simulation);
+    return out.flush();
+}
+
+//The simulation is left untouched if the file can not be loaded
+bool loadCheckpoint(QString fileName, Simulation& simulation)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    qint64 const size = file.size();
+    uchar const* data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data) {
+        return false;
+    }
+    CheckpointReader in(data, size);
+    Simulation loaded;
+    ActorStore actors;
+    bool const success = CheckpointIo::load(in, loaded, actors);
+    file.unmap(const_cast<uchar*>(data));
+    if (success) {
+        simulation = loaded;
+        simulation.actors.q1.swap(actors.q1);
+        simulation.actors.q2.swap(actors.q2);
+        simulation.actors.utility.swap(actors.utility);
+    }
+    return success;
+}
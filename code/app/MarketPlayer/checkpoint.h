@@ -0,0 +1,14 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <QString>
+
+#include "model.h"
+
+//Binary snapshot of a running simulation: the parameters, the actors, the progress of the round
+//and the history. A resumed simulation continues exactly as the saved one would have.
+//The file is memory-mapped when loaded, the actor columns are copied straight out of the mapping.
+bool saveCheckpoint(QString fileName, Simulation const& simulation);
+bool loadCheckpoint(QString fileName, Simulation& simulation);
+
+#endif // CHECKPOINT_H
@@ -5,10 +5,17 @@
 #include "qcustomplot.h"
 #include "plotutils.h"
 #include "strategymapper.h"
+#include "simulationconfig.h"
+#include "checkpoint.h"
+#include "sweep.h"
 
 #include <iostream>
 #include <time.h>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QProgressDialog>
+#include <QElapsedTimer>
+#include <thread>
 #include <QMap>
 
 using std::cout;
@@ -21,10 +28,18 @@ const QString MainWindow::mainSimulationID = "";
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    simulation(std::make_shared<Simulation>()),
+    workerGeneration(0),
+    isRunning(false),
+    ensembleCanceled(false),
+    ensembleProgress(nullptr),
+    lastPlotNanoseconds(0),
+    totalPlotNanoseconds(0)
 {
     globalUrng.seed(time(0));
     ui->setupUi(this);
+    plotRefreshScheduler = new PlotRefreshScheduler(this);
 
     appWaitingForSimulationLoaded.reset(new AppWaitingForSimulationLoaded(this));
     appInSimulationMode.reset(new AppInSimulationMode(this));
@@ -38,12 +53,20 @@ MainWindow::MainWindow(QWidget *parent) :
                           plotSumUtility.get(),
                           plotNumSuccessfulTrades.get(),
                           plotWealthDeviation.get(),
+                          plotWealthGini.get(),
+                          plotWealthTopShare.get(),
+                          plotWealthP10.get(),
+                          plotWealthP50.get(),
+                          plotWealthP90.get(),
+                          plotWealthP99.get(),
                           plotQ1Distribution.get(),
                           plotQ2Distribution.get(),
                           plotUtilityDistribution.get(),
-                          plotWealthDistribution.get()
+                          plotWealthDistribution.get(),
+                          plotRefreshScheduler
                           )
                       );
+    plotRefreshScheduler->addPlot(ui->plotEdgeworthBox, [this]() { plotNextSituation(); });
     caseManager->addExternalCase(mainSimulationID, simulation, Qt::blue, true);
 
     strategyMap[oppositeParetoValue] = ui->radioButtonOppositePareto;
@@ -66,18 +89,28 @@ MainWindow::MainWindow(QWidget *parent) :
 
 MainWindow::~MainWindow()
 {
+    ensembleCanceled = true;
+    if (ensembleThread.joinable()) {
+        ensembleThread.join();
+    }
+    workerThread.quit();
+    workerThread.wait();
     delete ui;
 }
 
 void MainWindow::setupSpeedControls()
 {
-    timer = new QTimer(this);
-    timer->setInterval(calculateSpeedInterval());
-    connect(timer, SIGNAL(timeout()),
-            ui->actionNextRound, SLOT(trigger()));
+    qRegisterMetaType<SimulationSnapshot>("SimulationSnapshot");
+    worker.reset(new SimulationWorker);
+    worker->moveToThread(&workerThread);
+    connect(worker.get(), SIGNAL(published()),
+            this, SLOT(onSimulationPublished()));
+    workerThread.start();
 
     ui->sliderSpeed->setMaximum(8);
     ui->sliderSpeed->setValue(2);
+
+    ui->spinBoxMaxFps->setValue(PlotRefreshScheduler::defaultMaxFramesPerSecond);
 }
 
 void MainWindow::setState(AppState *nextState)
@@ -99,19 +132,19 @@ void MainWindow::setupControlsAndUIStartup()
     ui->lineEditNumActors->setValidator(resourceValidator);
 
     auto alfaValidator = new QDoubleValidator(std::numeric_limits<Amount_t>::epsilon(), 1, 10, this);
-    ui->lineEditAlfa1->setText(QString::number(defaultAlfa1));
+    ui->lineEditAlfa1->setText(QString::number(SimulationConfig::defaultAlfa1));
     ui->lineEditAlfa1->setValidator(alfaValidator);
     ui->lineEditAlfa1->setEnabled(false); //TODO resolve
-    ui->lineEditAlfa2->setText(QString::number(defaultAlfa2));
+    ui->lineEditAlfa2->setText(QString::number(SimulationConfig::defaultAlfa2));
     ui->lineEditAlfa2->setValidator(alfaValidator);
     ui->lineEditAlfa2->setEnabled(false); //TODO resolve
 
     auto factorValidator =
             new QRegExpValidator(QRegExp(R"(^\-?\d*\.?\d*(e\-?\d*)?$)", Qt::CaseInsensitive), this);
-    ui->lineEditMinimumTradeAmountFactor->setText(QString::number(defaultMinTradeFactor));
+    ui->lineEditMinimumTradeAmountFactor->setText(QString::number(SimulationConfig::defaultMinTradeFactor));
     ui->lineEditMinimumTradeAmountFactor->setValidator(factorValidator);
 
-    ui->lineEditMaximumRoundsWithoutTrade->setText(QString::number(defaultMaxRoundWithoutTrade));
+    ui->lineEditMaximumRoundsWithoutTrade->setText(QString::number(SimulationConfig::defaultMaxRoundWithoutTrade));
     ui->lineEditMaximumRoundsWithoutTrade->setValidator(new QIntValidator(1,2000000000, this));
 
     ui->lineEditSeed->setValidator(new QIntValidator(0,std::numeric_limits<URNG::result_type>::max(), this));
@@ -140,6 +173,7 @@ void MainWindow::setupControlsAndUIStartup()
     setupSpeedControls();
 
     setupEdgeworthBox();
+    setupProfilingTable();
 
     plotQ1Traded.reset(new DataTimeRatioPlot(
         ui->plotQ1Traded, ui->labelQ1Traded, "Q1 traded", "Q1 traded"));
@@ -151,6 +185,18 @@ void MainWindow::setupControlsAndUIStartup()
         ui->plotNumSuccessfulTrades, ui->labelNumSuccessful, "Successful trades", "Successful trades"));
     plotWealthDeviation.reset(new DataTimePlot(
         ui->plotWealthDeviation, ui->labelWealthDeviation, "Wealth deviation", "Wealth deviation"));
+    plotWealthGini.reset(new DataTimePlot(
+        ui->plotWealthGini, ui->labelWealthGini, "Gini coefficient", "Gini coefficient"));
+    plotWealthTopShare.reset(new DataTimePlot(
+        ui->plotWealthTopShare, ui->labelWealthTopShare, "Top 1% wealth share", "Top 1% wealth share"));
+    plotWealthP10.reset(new DataTimePlot(
+        ui->plotWealthP10, ui->labelWealthP10, "Wealth p10", "Wealth p10"));
+    plotWealthP50.reset(new DataTimePlot(
+        ui->plotWealthP50, ui->labelWealthP50, "Wealth median", "Wealth median"));
+    plotWealthP90.reset(new DataTimePlot(
+        ui->plotWealthP90, ui->labelWealthP90, "Wealth p90", "Wealth p90"));
+    plotWealthP99.reset(new DataTimePlot(
+        ui->plotWealthP99, ui->labelWealthP99, "Wealth p99", "Wealth p99"));
 
     plotQ1Distribution.reset(new DistributionPlot(
         ui->plotQ1Distribution, "Q1", "Actors"));
@@ -202,6 +248,8 @@ void MainWindow::applyUIToApplicationStarted()
 
     ui->groupBoxHistory->setEnabled(false);
     ui->actionSaveConfiguration->setEnabled(false);
+    ui->actionSaveCheckpoint->setEnabled(false);
+    ui->actionRunEnsemble->setEnabled(false);
 
     ui->sliderTime->setMinimum(0);
     ui->sliderTime->setMaximum(0);
@@ -211,6 +259,12 @@ void MainWindow::applyUIToApplicationStarted()
     plotQ2Traded->clearData();
     plotSumUtility->clearData();
     plotWealthDeviation->clearData();
+    plotWealthGini->clearData();
+    plotWealthTopShare->clearData();
+    plotWealthP10->clearData();
+    plotWealthP50->clearData();
+    plotWealthP90->clearData();
+    plotWealthP99->clearData();
     plotNumSuccessfulTrades->clearData();
 
     plotQ1Distribution->clearData();
@@ -230,17 +284,28 @@ void MainWindow::applyUIToApplicationStarted()
 
 void MainWindow::applyUIToSimulationSetup()
 {
-    ui->progressBarRound->setMaximum(simulation.progress.getNum());
+    ui->progressBarRound->setMaximum(simulation->getNumMaxTrade());
 
     plotNextSituation();
-    loadHistoryMoment(simulation.history.time - 1);
+    caseManager->resetPlotData(mainSimulationID);
+    loadHistoryMoment(simulation->history.time - 1);
     updateProgress();
     updateTimeRangeBySimulation();
+    lastPlotNanoseconds = 0;
+    totalPlotNanoseconds = 0;
+    lastRoundProfile.reset();
+    totalProfile.reset();
+    updateProfiling();
+    loadSimulationIntoWorker();
 
     changeToTab(ui->tabWidget, ui->tabMainOverview);
     ui->groupBoxHistory->setEnabled(true);
     ui->actionSaveConfiguration->setEnabled(true);
+    ui->actionSaveCheckpoint->setEnabled(true);
+    ui->actionRunEnsemble->setEnabled(true);
     unmarkParameterControls();
+    //an ensemble belongs to the configuration it was run with
+    caseManager->setEnsemble(mainSimulationID, nullptr);
 }
 
 void MainWindow::setupEdgeworthBox()
@@ -308,26 +373,19 @@ void MainWindow::setupEdgeworthBox()
 void MainWindow::plotEdgeworth(QCustomPlot* plot, EdgeworthSituation const& situation) {
     clearPlotData(plot);
 
-    Amount_t const q1RangeStart = std::numeric_limits<Amount_t>::epsilon();
-    Amount_t const q1Resolution = situation.q1Sum / 4000; //todo generalize
-
     plot->xAxis->setRange(0.0, situation.q1Sum);
     plot->yAxis->setRange(0.0, situation.q2Sum);
 
+    edgeworthCurves.update(situation);
+
     auto curve1Graph = plot->graph(0);
-    ResourceDataPair data1 = sampleFunction(
-                situation.getCurve1Function(), q1RangeStart, situation.q1Sum, q1Resolution);
-    curve1Graph->setData(data1.x, data1.y);
+    curve1Graph->setData(edgeworthCurves.curve1.x, edgeworthCurves.curve1.y);
 
     auto curve2Graph = plot->graph(1);
-    ResourceDataPair data2 = sampleFunction(situation.getCurve2Function(),
-                                            q1RangeStart, situation.q1Sum, q1Resolution);
-    curve2Graph->setData(data2.x, data2.y);
+    curve2Graph->setData(edgeworthCurves.curve2.x, edgeworthCurves.curve2.y);
 
     auto paretoSet = plot->graph(2);
-    ResourceDataPair paretoData = sampleFunction(situation.getParetoSetFunction(),
-                                                 q1RangeStart, situation.q1Sum, q1Resolution);
-    paretoSet->setData(paretoData.x, paretoData.y);
+    paretoSet->setData(edgeworthCurves.paretoSet.x, edgeworthCurves.paretoSet.y);
 
     auto pointsGraph = plot->graph(3);
     auto fixPoint = situation.getFixPoint();
@@ -357,8 +415,8 @@ void MainWindow::updateTimeRange(size_t maxTimeIdx)
 
 void MainWindow::updateTimeRangeBySimulation()
 {
-    updateTimeRange(simulation.history.time - 1);
-    setSelectedTimeIdx(simulation.history.time - 1); //always showing the last moment
+    updateTimeRange(simulation->history.time - 1);
+    setSelectedTimeIdx(simulation->history.time - 1); //always showing the last moment
 }
 
 void MainWindow::setSelectedTimeIdx(size_t timeIdx)
@@ -371,13 +429,16 @@ void MainWindow::setSelectedTimeIdx(size_t timeIdx)
 
 void MainWindow::plotNextSituation()
 {
-    EdgeworthSituation const& nextSituation = simulation.provideNextSituation();
+    EdgeworthSituation const nextSituation = simulation->hasActors() ? simulation->getNextSituation()
+                                                                     : *publishedSituation;
     plotEdgeworth(ui->plotEdgeworthBox, nextSituation);
 }
 
 bool MainWindow::trySetupSimulationByForm()
 {
-    bool success = simulation.setup(ui->lineEditSeed->text().toUInt(),
+    //a copy keeps the settings the form does not show, like the retention policy
+    std::shared_ptr<Simulation> const next = std::make_shared<Simulation>(*simulation);
+    bool success = next->setup(ui->lineEditSeed->text().toUInt(),
                      ui->lineEditNumActors->text().toInt(),
                      ui->lineEditSumQ1->text().toDouble(),
                      ui->lineEditSumQ2->text().toDouble(),
@@ -395,7 +456,6 @@ bool MainWindow::trySetupSimulationByForm()
         } else {
             offerStrategy.reset(new RandomTriangleOfferStrategy);
         }
-        simulation.offerStrategy = std::move(offerStrategy);
 
         unique_ptr<AbstractAcceptanceStrategy> acceptanceStrategy;
         if (ui->radioButtonWantAlways->isChecked()) {
@@ -405,14 +465,15 @@ bool MainWindow::trySetupSimulationByForm()
         } else {
             acceptanceStrategy.reset(new HigherProportionAcceptanceStrategy);
         }
-        simulation.acceptanceStrategy = std::move(acceptanceStrategy);
+        next->setStrategies(std::move(offerStrategy), std::move(acceptanceStrategy));
+        simulation = next;
     }
     return success;
 }
 
 void MainWindow::setupSimulationByHistory(const AbstractSimulationCase &simulationCase)
 {
-    simulation = simulationCase.getSimulation();
+    simulation = std::make_shared<Simulation const>(simulationCase.getSimulation());
 }
 
 void MainWindow::updateParameterControlsFromSimulation(const Simulation &simulation)
@@ -420,8 +481,8 @@ void MainWindow::updateParameterControlsFromSimulation(const Simulation &simulat
     ui->lineEditNumActors->setText(QString::number(simulation.numActors));
     ui->lineEditSumQ1->setText(QString::number(simulation.amounts[0]));
     ui->lineEditSumQ2->setText(QString::number(simulation.amounts[1]));
-    ui->lineEditAlfa1->setText(QString::number(simulation.utility.alfa1));
-    ui->lineEditAlfa2->setText(QString::number(simulation.utility.alfa2));
+    ui->lineEditAlfa1->setText(QString::number(simulation.utility.getAlfa1()));
+    ui->lineEditAlfa2->setText(QString::number(simulation.utility.getAlfa2()));
     ui->lineEditSeed->setText(QString::number(simulation.seed));
     ui->lineEditMinimumTradeAmountFactor->setText(QString::number(simulation.minTradeFactor));
     ui->lineEditMaximumRoundsWithoutTrade->setText(QString::number(simulation.maxRoundWithoutTrade));
@@ -441,10 +502,80 @@ void MainWindow::updateParameterControlsFromSimulation(const Simulation &simulat
 
 void MainWindow::updateProgress()
 {
-    ui->labelProgress->setText(QString::number(simulation.progress.getDone())
+    ui->labelProgress->setText(QString::number(simulation->progress.getDone())
                                + "/"
-                               + QString::number(simulation.progress.getNum()));
-    ui->progressBarRound->setValue(simulation.progress.getDone());
+                               + QString::number(simulation->getNumMaxTrade()));
+    ui->progressBarRound->setValue(simulation->progress.getDone());
+}
+
+void MainWindow::setupProfilingTable()
+{
+    QStringList const rowNames = {
+        "Situation (ms)", "Propose (ms)", "Consider (ms)", "Trade (ms)",
+        "Distributions (ms)", "Save history (ms)", "Simulation wall time (ms)", "Plotting (ms)",
+        "Rounds", "Pairs", "Accepted trades", "Rejected by consider", "Rejected below minimum trade",
+        "Timed pairs"
+    };
+    ui->tableWidgetProfiling->setRowCount(rowNames.size());
+    ui->tableWidgetProfiling->setVerticalHeaderLabels(rowNames);
+    ui->labelProfilingNote->setText(
+                QString("Phase times are summed over the threads. Situation, propose, consider and trade "
+                        "are timed on every %1th pair and scaled to all pairs.").arg(RoundProfile::sampleInterval));
+}
+
+void MainWindow::updateProfiling()
+{
+    RoundProfile const* const profiles[] = { &lastRoundProfile, &totalProfile };
+    qint64 const plotNanoseconds[] = { lastPlotNanoseconds, totalPlotNanoseconds };
+    auto const formatMilliseconds = [](double seconds) { return QString::number(seconds * 1e3, 'f', 3); };
+    for (int columnIdx = 0; columnIdx < 2; ++columnIdx) {
+        RoundProfile const& profile = *profiles[columnIdx];
+        QStringList values;
+        for (int phase = 0; phase < RoundProfile::NumPhases; ++phase) {
+            values << formatMilliseconds(profile.getEstimatedSeconds(static_cast<RoundProfile::Phase>(phase)));
+        }
+        values << formatMilliseconds(profile.getWallSeconds())
+               << formatMilliseconds(plotNanoseconds[columnIdx] * 1e-9)
+               << QString::number(profile.numRounds)
+               << QString::number(profile.numPairs)
+               << QString::number(profile.numAccepted)
+               << QString::number(profile.numRejectedByConsider)
+               << QString::number(profile.numRejectedByMinimum)
+               << QString::number(profile.numSampledPairs);
+        for (int rowIdx = 0; rowIdx < values.size(); ++rowIdx) {
+            auto item = new QTableWidgetItem(values[rowIdx]);
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            ui->tableWidgetProfiling->setItem(rowIdx, columnIdx, item);
+        }
+    }
+}
+
+//The worker continues from the shown simulation, whatever it was running is dropped
+void MainWindow::loadSimulationIntoWorker()
+{
+    ++workerGeneration;
+    QMetaObject::invokeMethod(worker.get(), "load", Qt::QueuedConnection,
+                              Q_ARG(SimulationSnapshot, simulation),
+                              Q_ARG(quint64, workerGeneration));
+}
+
+//The snapshots of running rounds leave out the actors. The worker hands over its whole simulation then,
+//which may be a round ahead of the shown one.
+void MainWindow::provideActors()
+{
+    if (simulation->hasActors()) {
+        return;
+    }
+    SimulationSnapshot whole;
+    QMetaObject::invokeMethod(worker.get(), "takeSnapshot", Qt::BlockingQueuedConnection,
+                              Q_RETURN_ARG(SimulationSnapshot, whole));
+    //published before the call, so not newer than the whole one
+    worker->takePublished();
+    simulation = whole;
+    publishedSituation.reset();
+    plotRefreshScheduler->markDirty(ui->plotEdgeworthBox);
+    updateTimeRangeBySimulation();
+    updateProgress();
 }
 
 void MainWindow::updateCaseInput()
@@ -477,7 +608,9 @@ void MainWindow::addCaseRow(bool visible)
         msgBox.exec();
     } else {
         auto const color = getButtonColor(ui->pushButtonCaseColor);
+        provideActors();
         caseManager->addHeavyCase(caseName, simulation, color, visible);
+        caseManager->setEnsemble(caseName, caseManager->getEnsemble(mainSimulationID));
 
         auto const rowIdx = getNumCaseRows();
         ui->tableWidgetCases->insertRow(rowIdx);
@@ -651,29 +784,43 @@ void MainWindow::on_actionApply_triggered()
     }
 }
 
-void MainWindow::on_actionNextRound_triggered()
+//Shows the newest step of the worker, the ones published meanwhile are already contained in it
+void MainWindow::onSimulationPublished()
 {
-    auto tabIdx = ui->tabWidget->currentIndex();
-    if (simulation.canContinueSimulation()) {
-        if ( ui->tabWidget->indexOf(ui->tabEdgeworthBox) == tabIdx ) {
-            while(!simulation.progress.wasRestarted()) {
-                on_actionNextTrade_triggered();
-            }
-        } else {
-            simulation.performNextRound();
-            plotNextSituation();
-        }
-        updateTimeRangeBySimulation();
-        updateProgress();
+    std::unique_ptr<PublishedSimulation> const published = worker->takePublished();
+    if (!published || published->generation != workerGeneration) {
+        return;
     }
-    if (!simulation.canContinueSimulation()) {
+    QElapsedTimer plotTimer;
+    plotTimer.start();
+    simulation = published->simulation;
+    publishedSituation = published->nextSituation;
+    lastRoundProfile = published->lastRoundProfile;
+    totalProfile = published->totalProfile;
+    plotRefreshScheduler->markDirty(ui->plotEdgeworthBox);
+    updateTimeRangeBySimulation();
+    updateProgress();
+    //the plots are redrawn by the frames, counted here with the ones since the previous step
+    lastPlotNanoseconds = plotTimer.nsecsElapsed() + plotRefreshScheduler->takeRefreshNanoseconds();
+    totalPlotNanoseconds += lastPlotNanoseconds;
+    updateProfiling();
+    if (!simulation->canContinueSimulation()) {
         on_actionPause_triggered();
+        ui->statusBar->showMessage(
+                    "Stopped by " + QString::fromStdString(simulation->getStoppingRule()->describe()));
     }
 }
 
+void MainWindow::on_actionNextRound_triggered()
+{
+    QMetaObject::invokeMethod(worker.get(), "performNextRound", Qt::QueuedConnection);
+}
+
 void MainWindow::on_actionStart_triggered()
 {
-    timer->start();
+    isRunning = true;
+    QMetaObject::invokeMethod(worker.get(), "start", Qt::QueuedConnection,
+                              Q_ARG(int, calculateSpeedInterval()));
 
     ui->actionStart->setEnabled(false);
     ui->actionPause->setEnabled(true);
@@ -683,7 +830,9 @@ void MainWindow::on_actionStart_triggered()
 
 void MainWindow::on_actionPause_triggered()
 {
-    timer->stop();
+    //a round already running on the worker still finishes and gets shown
+    isRunning = false;
+    QMetaObject::invokeMethod(worker.get(), "pause", Qt::QueuedConnection);
 
     ui->actionNextRound->setEnabled(true);
     ui->actionStart->setEnabled(true);
@@ -694,19 +843,18 @@ void MainWindow::on_actionPause_triggered()
 
 void MainWindow::on_actionNextTrade_triggered()
 {
-    if (simulation.canContinueSimulation()) {
-        bool const isFinished = simulation.performNextTrade();
-        updateProgress();
-        if (isFinished) {
-            updateTimeRangeBySimulation();
-        }
-        plotNextSituation();
-    }
+    QMetaObject::invokeMethod(worker.get(), "performNextTrade", Qt::QueuedConnection);
 }
 
 void MainWindow::on_sliderSpeed_valueChanged(int)
 {
-    timer->setInterval(calculateSpeedInterval());
+    QMetaObject::invokeMethod(worker.get(), "setInterval", Qt::QueuedConnection,
+                              Q_ARG(int, calculateSpeedInterval()));
+}
+
+void MainWindow::on_spinBoxMaxFps_valueChanged(int value)
+{
+    plotRefreshScheduler->setMaxFramesPerSecond(value);
 }
 
 void MainWindow::on_sliderTime_valueChanged(int value)
@@ -719,24 +867,6 @@ void MainWindow::on_pushButtonRegenerateSeed_clicked()
     ui->lineEditSeed->setText(QString::number(globalUrng()));
 }
 
-QString appGroupKey = "application";
-QString configVersionKey = "config_version";
-QString currentConfigVersion = "1.1";
-
-//since 1.0
-QString simulationGroupKey = "simulation";
-QString q1SumKey = "q1_sum";
-QString q2SumKey = "q2_sum";
-QString numActorsKey = "num_actors";
-QString randomSeedKey = "random_seed";
-
-QString offerStrategyKey = "offer_strategy";
-QString acceptanceStrategyKey = "acceptance_strategy";
-
-//since 1.1
-QString minTradeFactorKey = "min_trade_factor";
-QString maxRoundWithoutTradeKey = "max_round_without_trade";
-
 void MainWindow::on_actionSaveConfiguration_triggered()
 {
     QString fileName = QFileDialog::getSaveFileName(this, "Save configuration", "", "(*ini).");
@@ -744,23 +874,7 @@ void MainWindow::on_actionSaveConfiguration_triggered()
         if (!fileName.endsWith(".ini")) {
             fileName += ".ini";
         }
-        QSettings settings(fileName, QSettings::IniFormat);
-        settings.beginGroup(appGroupKey);
-        settings.setValue(configVersionKey, currentConfigVersion);
-        settings.endGroup();
-
-        settings.beginGroup(simulationGroupKey);
-        settings.setValue(q1SumKey, QString::number(simulation.amounts[0]));
-        settings.setValue(q2SumKey, QString::number(simulation.amounts[1]));
-        settings.setValue(numActorsKey, QString::number(simulation.numActors));
-        settings.setValue(randomSeedKey, QString::number(simulation.seed));
-        settings.setValue(minTradeFactorKey, QString::number(simulation.minTradeFactor));
-        settings.setValue(maxRoundWithoutTradeKey, QString::number(simulation.maxRoundWithoutTrade));
-        OfferStrategyNameVisitor ov;
-        settings.setValue(offerStrategyKey, ov.getStrategyDescription(*simulation.offerStrategy));
-        AcceptanceStrategyNameVisitor av;
-        settings.setValue(acceptanceStrategyKey, av.getStrategyDescription(*simulation.acceptanceStrategy));
-        settings.endGroup();
+        saveSimulationConfig(fileName, configFromSimulation(*simulation));
     }
 }
 
@@ -770,46 +884,131 @@ void MainWindow::on_actionLoadConfiguration_triggered()
     if (fileName != "") {
         currentState->beforeSimulationSetup();
 
-        QSettings settings(fileName, QSettings::IniFormat);
-        settings.beginGroup(appGroupKey);
-        QString fileConfigVersion = settings.value(configVersionKey).toString();
-        settings.endGroup();
-
-        settings.beginGroup(simulationGroupKey);
-
-        unsigned amountQ1 = settings.value(q1SumKey).toUInt();
-        unsigned amountQ2 = settings.value(q2SumKey).toUInt();
-        size_t numActors = settings.value(numActorsKey).toUInt();
-        URNG::result_type seed = settings.value(randomSeedKey).toUInt();
-        double alfa1 = defaultAlfa1;
-        double alfa2 = defaultAlfa2;
-
-        double minTradeFactor = defaultMinTradeFactor;
-        double maxRoundWithoutTrade = defaultMaxRoundWithoutTrade;
-        if (fileConfigVersion >= "1.1") {
-            minTradeFactor = settings.value(minTradeFactorKey).toDouble();
-            maxRoundWithoutTrade = settings.value(maxRoundWithoutTradeKey).toDouble();
+        SimulationConfig config;
+        std::shared_ptr<Simulation> const next = std::make_shared<Simulation>(*simulation);
+        bool success = loadSimulationConfig(fileName, config)
+                && setupSimulationByConfig(*next, config);
+        if (success) {
+            simulation = next;
+            updateParameterControlsFromSimulation(*simulation);
+            applyUIToSimulationSetup();
+            currentState->simulationSetupOccured();
+        } else {
+            QMessageBox msgBox;
+            msgBox.setText("The simulation could not be setup using this configuration file!");
+            msgBox.exec();
+        }
+    }
+}
+
+void MainWindow::on_actionSaveCheckpoint_triggered()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Save checkpoint", "", "(*mpc).");
+    if (fileName != "") {
+        if (!fileName.endsWith(".mpc")) {
+            fileName += ".mpc";
         }
+        provideActors();
+        if (!saveCheckpoint(fileName, *simulation)) {
+            QMessageBox msgBox;
+            msgBox.setText("The checkpoint could not be written!");
+            msgBox.exec();
+        }
+    }
+}
 
-        QString offerStrategy = settings.value(offerStrategyKey).toString();
-        QString acceptanceStrategy = settings.value(acceptanceStrategyKey).toString();
-        settings.endGroup();
+void MainWindow::on_actionLoadCheckpoint_triggered()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, "Load checkpoint", "", "(*mpc).");
+    if (fileName != "") {
+        currentState->beforeSimulationSetup();
 
-        bool success = simulation.setup(seed, numActors, amountQ1, amountQ2, alfa1, alfa2, minTradeFactor, maxRoundWithoutTrade);
-        if (success) {
-            simulation.offerStrategy = createOfferStrategy(offerStrategy);
-            simulation.acceptanceStrategy = createAcceptanceStrategy(acceptanceStrategy);
-            updateParameterControlsFromSimulation(simulation);
+        std::shared_ptr<Simulation> const next = std::make_shared<Simulation>();
+        if (loadCheckpoint(fileName, *next)) {
+            simulation = next;
+            updateParameterControlsFromSimulation(*simulation);
             applyUIToSimulationSetup();
             currentState->simulationSetupOccured();
         } else {
             QMessageBox msgBox;
-            msgBox.setText("The simulation could not be setup using this configuration file!");
+            msgBox.setText("The simulation could not be resumed from this checkpoint file!");
             msgBox.exec();
         }
     }
 }
 
+//Runs the current configuration with consecutive seeds and shows the 95% confidence bands of the mean
+void MainWindow::on_actionRunEnsemble_triggered()
+{
+    bool accepted = false;
+    int const numRuns = QInputDialog::getInt(this, "Run ensemble", "Number of seeds, counting up from the current one:",
+                                             100, 2, 1000000, 1, &accepted);
+    if (!accepted) {
+        return;
+    }
+    if (isRunning) {
+        on_actionPause_triggered();
+    }
+
+    SimulationConfig const config = configFromSimulation(*simulation);
+    size_t const numThreads = std::max(1u, std::thread::hardware_concurrency());
+    runningEnsemble = std::make_shared<Ensemble>();
+    ensembleCanceled = false;
+    ensembleProgress = new QProgressDialog("Running the ensemble...", "Cancel", 0, numRuns, this);
+    ensembleProgress->setWindowModality(Qt::WindowModal);
+    ensembleProgress->setAutoClose(false);
+    ensembleProgress->setAutoReset(false);
+    connect(ensembleProgress, SIGNAL(canceled()),
+            this, SLOT(onEnsembleCanceled()));
+    ensembleProgress->show();
+    ui->actionRunEnsemble->setEnabled(false);
+
+    //the thread only touches the ensemble, which the window leaves alone until onEnsembleFinished
+    std::shared_ptr<Ensemble> const ensemble = runningEnsemble;
+    ensembleThread = std::thread([this, config, numRuns, numThreads, ensemble]() {
+        bool const success = runEnsemble(config, 0, numRuns, numThreads, *ensemble, &ensembleCanceled,
+                                         [this](size_t numFinishedRuns) {
+            QMetaObject::invokeMethod(this, "onEnsembleRunFinished", Qt::QueuedConnection,
+                                      Q_ARG(int, static_cast<int>(numFinishedRuns)));
+        });
+        QMetaObject::invokeMethod(this, "onEnsembleFinished", Qt::QueuedConnection,
+                                  Q_ARG(bool, success));
+    });
+}
+
+void MainWindow::onEnsembleRunFinished(int numFinishedRuns)
+{
+    if (ensembleProgress && !ensembleCanceled) {
+        ensembleProgress->setValue(numFinishedRuns);
+    }
+}
+
+//The runs in progress stop after their current round, onEnsembleFinished follows
+void MainWindow::onEnsembleCanceled()
+{
+    ensembleCanceled = true;
+    ensembleProgress->setLabelText("Canceling the ensemble...");
+}
+
+void MainWindow::onEnsembleFinished(bool success)
+{
+    ensembleThread.join();
+    ensembleProgress->deleteLater();
+    ensembleProgress = nullptr;
+    ui->actionRunEnsemble->setEnabled(true);
+    std::shared_ptr<Ensemble> const ensemble = runningEnsemble;
+    runningEnsemble.reset();
+
+    if (!success) {
+        QMessageBox msgBox;
+        msgBox.setText("The ensemble could not be run using these parameters!");
+        msgBox.exec();
+    } else if (ensemble->getNumRuns() > 1) {
+        //a cancelled ensemble is shown with the runs finished so far
+        caseManager->setEnsemble(mainSimulationID, ensemble);
+    }
+}
+
 void MainWindow::on_pushButtonClearHistory_clicked()
 {
     removeCaseRows([](int){return true;}); //remove all lines
@@ -850,9 +1049,11 @@ void MainWindow::on_pushButtonLoadSelectedOutput_clicked()
     int idx = getFirstSelectedSimulationCaseRow();
     if (idx > -1) {
         currentState->beforeSimulationSetup();
-        setupSimulationByHistory(caseManager->getSimulationCase(getCaseNameFromRow(idx)));
-        updateParameterControlsFromSimulation(simulation);
+        auto const caseName = getCaseNameFromRow(idx);
+        setupSimulationByHistory(caseManager->getSimulationCase(caseName));
+        updateParameterControlsFromSimulation(*simulation);
         applyUIToSimulationSetup();
+        caseManager->setEnsemble(mainSimulationID, caseManager->getEnsemble(caseName));
         currentState->simulationSetupOccured();
     }
 }
@@ -914,6 +1115,6 @@ void MainWindow::on_tableWidgetCases_itemSelectionChanged()
 
 void MainWindow::on_actionRevertChanges_triggered()
 {
-    updateParameterControlsFromSimulation(simulation);
+    updateParameterControlsFromSimulation(*simulation);
     unmarkParameterControls();
 }
@@ -2,9 +2,12 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QThread>
+#include <atomic>
 #include <memory>
 #include <map>
 #include <functional>
+#include <thread>
 
 #include "model.h"
 #include "datatimeplot.h"
@@ -14,6 +17,9 @@
 #include "colormanager.h"
 #include "casenamemanager.h"
 #include "casemanager.h"
+#include "plotrefreshscheduler.h"
+#include "edgeworthcurves.h"
+#include "simulationworker.h"
 #include "appstate.h"
 #include "appwaitingforsimulationloaded.h"
 #include "appinsimulationmode.h"
@@ -23,6 +29,8 @@ namespace Ui {
 class MainWindow;
 }
 
+class QProgressDialog;
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -62,6 +70,10 @@ private:
     void updateTimeRangeBySimulation();
     void setSelectedTimeIdx(size_t timeIdx);
     void updateProgress();
+    void setupProfilingTable();
+    void updateProfiling();
+    void loadSimulationIntoWorker();
+    void provideActors();
 
     void updateCaseInput();
     QColor getButtonColor(QPushButton* button) const;
@@ -87,6 +99,10 @@ private slots:
     void on_buttonGroupOfferStrategy_buttonClicked(int buttonID);
     void on_buttonGroupAcceptanceStrategy_buttonClicked(int buttonID);
     void onButtonGroupOverviewMode_buttonClicked(int buttonID);
+    void onSimulationPublished();
+    void onEnsembleRunFinished(int numFinishedRuns);
+    void onEnsembleFinished(bool success);
+    void onEnsembleCanceled();
 
     void on_actionSaveEdgeworthDiagram_triggered();
 
@@ -102,6 +118,8 @@ private slots:
 
     void on_sliderSpeed_valueChanged(int value);
 
+    void on_spinBoxMaxFps_valueChanged(int value);
+
     void on_sliderTime_valueChanged(int value);
 
     void on_pushButtonRegenerateSeed_clicked();
@@ -110,6 +128,12 @@ private slots:
 
     void on_actionLoadConfiguration_triggered();
 
+    void on_actionSaveCheckpoint_triggered();
+
+    void on_actionLoadCheckpoint_triggered();
+
+    void on_actionRunEnsemble_triggered();
+
     void on_pushButtonClearHistory_clicked();
 
     void on_pushButtonAddCurrentOutput_clicked();
@@ -152,17 +176,40 @@ private:
 
     //the window handles ownership:
     Ui::MainWindow *ui;
-    QTimer* timer;
+    PlotRefreshScheduler* plotRefreshScheduler;
     //
 
     unique_ptr<CaseManager> caseManager;
-    Simulation simulation;
+    //the shown simulation, the worker runs its own and publishes the finished steps as snapshots,
+    //which are shown as they are. Changing the parameters replaces it by a new one.
+    SimulationSnapshot simulation;
+    //published with the snapshots that leave out the actors
+    std::shared_ptr<EdgeworthSituation const> publishedSituation;
+    QThread workerThread;
+    unique_ptr<SimulationWorker> worker;
+    //bumped by every load, tells the snapshots of the replaced simulation apart
+    quint64 workerGeneration;
+    bool isRunning;
+    //the ensemble runs on its own thread and only reports back through queued calls
+    std::thread ensembleThread;
+    std::atomic<bool> ensembleCanceled;
+    std::shared_ptr<Ensemble> runningEnsemble;
+    QProgressDialog* ensembleProgress;
+    RoundProfile lastRoundProfile;
+    RoundProfile totalProfile;
+    EdgeworthCurves edgeworthCurves;
 
     unique_ptr<DataTimeRatioPlot> plotQ1Traded;
     unique_ptr<DataTimeRatioPlot> plotQ2Traded;
     unique_ptr<DataTimePlot> plotSumUtility;
     unique_ptr<DataTimeRatioPlot> plotNumSuccessfulTrades;
     unique_ptr<DataTimePlot> plotWealthDeviation;
+    unique_ptr<DataTimePlot> plotWealthGini;
+    unique_ptr<DataTimePlot> plotWealthTopShare;
+    unique_ptr<DataTimePlot> plotWealthP10;
+    unique_ptr<DataTimePlot> plotWealthP50;
+    unique_ptr<DataTimePlot> plotWealthP90;
+    unique_ptr<DataTimePlot> plotWealthP99;
 
     unique_ptr<DistributionPlot> plotQ1Distribution;
     unique_ptr<DistributionPlot> plotQ2Distribution;
@@ -171,18 +218,16 @@ private:
 
     std::map<QString, QRadioButton*> strategyMap;
 
+    //time of redrawing after the rounds, shown next to the profile of the simulation
+    qint64 lastPlotNanoseconds;
+    qint64 totalPlotNanoseconds;
+
     ColorManager colorManager;
     CaseNameManager caseNameManager;
     static const int caseNameColumnIdx = 0;
     static const int caseColorColumnIdx = 1;
     static const int checkBoxColumnIdx = 2;
 
-    static constexpr double defaultAlfa1 = 0.5;
-    static constexpr double defaultAlfa2 = 0.5;
-
-    static constexpr double defaultMinTradeFactor = 0.01;
-    static const size_t defaultMaxRoundWithoutTrade = 2;
-
     static const QString mainSimulationID;
 };
 
@@ -0,0 +1,116 @@
+#include "actorkernels.h"
+#include "model.h"
+
+#include <cmath>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void computeUtilitiesScalar(double alfa1, double alfa2,
+                            Amount_t const* q1, Amount_t const* q2, Amount_t* result, size_t count)
+{
+    Utility const utility(alfa1, alfa2);
+    for (size_t idx = 0; idx < count; ++idx) {
+        result[idx] = utility.compute(q1[idx], q2[idx]);
+    }
+}
+
+#if defined(__AVX512F__)
+
+typedef __m512d Lane;
+size_t const laneWidth = 8;
+
+inline __m512d loadLane(Amount_t const* p) { return _mm512_loadu_pd(p); }
+inline void storeLane(Amount_t* p, __m512d v) { _mm512_storeu_pd(p, v); }
+inline __m512d broadcast(double v) { return _mm512_set1_pd(v); }
+inline __m512d add(__m512d a, __m512d b) { return _mm512_add_pd(a, b); }
+inline __m512d mul(__m512d a, __m512d b) { return _mm512_mul_pd(a, b); }
+inline __m512d squareRoot(__m512d a) { return _mm512_sqrt_pd(a); }
+inline double horizontalSum(__m512d v) { return _mm512_reduce_add_pd(v); }
+
+#elif defined(__AVX2__)
+
+typedef __m256d Lane;
+size_t const laneWidth = 4;
+
+inline __m256d loadLane(Amount_t const* p) { return _mm256_loadu_pd(p); }
+inline void storeLane(Amount_t* p, __m256d v) { _mm256_storeu_pd(p, v); }
+inline __m256d broadcast(double v) { return _mm256_set1_pd(v); }
+inline __m256d add(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+inline __m256d mul(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+inline __m256d squareRoot(__m256d a) { return _mm256_sqrt_pd(a); }
+inline double horizontalSum(__m256d v) {
+    __m128d const low = _mm256_castpd256_pd128(v);
+    __m128d const high = _mm256_extractf128_pd(v, 1);
+    __m128d const pair = _mm_add_pd(low, high);
+    return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+
+bool isSquareRootUtility(double alfa1, double alfa2)
+{
+    return alfa1 == 0.5 && alfa2 == 0.5;
+}
+
+//Only sqrt(q1*q2) is vectorized: it is correctly rounded in both paths, so the results equal Utility::compute.
+//Vectorizing the pow and exp/log forms would change the stored utilities with the build flags.
+void computeUtilitiesVector(double alfa1, double alfa2,
+                            Amount_t const* q1, Amount_t const* q2, Amount_t* result, size_t count)
+{
+    size_t idx = 0;
+    if (isSquareRootUtility(alfa1, alfa2)) {
+        size_t const vectorCount = count - count % laneWidth;
+        for (; idx < vectorCount; idx += laneWidth) {
+            storeLane(result + idx, squareRoot(mul(loadLane(q1 + idx), loadLane(q2 + idx))));
+        }
+    }
+    computeUtilitiesScalar(alfa1, alfa2, q1 + idx, q2 + idx, result + idx, count - idx);
+}
+
+Amount_t sumAmountsVector(Amount_t const* subject, size_t count)
+{
+    size_t const vectorCount = count - count % laneWidth;
+    Lane sum = broadcast(0.0);
+    size_t idx = 0;
+    for (; idx < vectorCount; idx += laneWidth) {
+        sum = add(sum, loadLane(subject + idx));
+    }
+    Amount_t result = horizontalSum(sum);
+    for (; idx < count; ++idx) {
+        result += subject[idx];
+    }
+    return result;
+}
+
+#endif
+
+}
+
+void computeUtilities(double alfa1, double alfa2,
+                      const Amount_t* q1, const Amount_t* q2, Amount_t* result, size_t count)
+{
+#if defined(__AVX512F__) || defined(__AVX2__)
+    computeUtilitiesVector(alfa1, alfa2, q1, q2, result, count);
+#else
+    computeUtilitiesScalar(alfa1, alfa2, q1, q2, result, count);
+#endif
+}
+
+Amount_t sumAmounts(const Amount_t* subject, size_t count)
+{
+#if defined(__AVX512F__) || defined(__AVX2__)
+    return sumAmountsVector(subject, count);
+#else
+    Amount_t result = 0.0;
+    for (size_t idx = 0; idx < count; ++idx) {
+        result += subject[idx];
+    }
+    return result;
+#endif
+}
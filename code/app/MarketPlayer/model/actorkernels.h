@@ -0,0 +1,22 @@
+#ifndef ACTORKERNELS_H
+#define ACTORKERNELS_H
+
+#include <cstddef>
+
+#include "modelutils.h"
+
+//Batch kernels over the actor columns.
+//The instruction set is chosen at compile time (see model/model.pri: simd_avx2, simd_avx512),
+//without those the scalar fallback is used.
+//computeUtilities gives exactly the results of Utility::compute with any instruction set:
+//only the equal halves, sqrt(q1*q2), are vectorized, the other exponents take the scalar path.
+//saveHistory takes no kernel: the distributions follow the trades (RunningDistribution) and are refilled
+//by Simulation::rebuildDistributions. Its wealths stay scalar, the removals must find the buckets
+//computeWealth gave, which a contracted or reordered vector product would not guarantee.
+
+void computeUtilities(double alfa1, double alfa2,
+                      Amount_t const* q1, Amount_t const* q2, Amount_t* result, size_t count);
+
+Amount_t sumAmounts(Amount_t const* subject, size_t count);
+
+#endif // ACTORKERNELS_H
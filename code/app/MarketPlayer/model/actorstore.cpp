@@ -0,0 +1,15 @@
+#include "actorstore.h"
+
+void ActorStore::resize(size_t numActors)
+{
+    q1.resize(numActors);
+    q2.resize(numActors);
+    utility.resize(numActors);
+}
+
+void ActorStore::detach()
+{
+    q1.provideOwn();
+    q2.provideOwn();
+    utility.provideOwn();
+}
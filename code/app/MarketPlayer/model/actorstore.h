@@ -0,0 +1,102 @@
+#ifndef ACTORSTORE_H
+#define ACTORSTORE_H
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "modelutils.h"
+
+//Keeps the columns on cache line boundaries, so a vector lane of the batch kernels
+//never straddles two cache lines (they still use unaligned loads, which cost the same on aligned data).
+template<typename T, size_t Alignment>
+struct AlignedAllocator
+{
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+    AlignedAllocator() {}
+    template<typename U>
+    AlignedAllocator(AlignedAllocator<U, Alignment> const&) {}
+
+    T* allocate(size_t n) {
+        void* memory = nullptr;
+#ifdef _MSC_VER
+        memory = _aligned_malloc(n * sizeof(T), Alignment);
+#else
+        if (posix_memalign(&memory, Alignment, n * sizeof(T)) != 0) {
+            memory = nullptr;
+        }
+#endif
+        if (!memory) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T* p, size_t) {
+#ifdef _MSC_VER
+        _aligned_free(p);
+#else
+        free(p);
+#endif
+    }
+
+    template<typename U>
+    bool operator==(AlignedAllocator<U, Alignment> const&) const { return true; }
+    template<typename U>
+    bool operator!=(AlignedAllocator<U, Alignment> const&) const { return false; }
+};
+
+static const size_t actorColumnAlignment = 64;
+
+typedef std::vector<Amount_t, AlignedAllocator<Amount_t, actorColumnAlignment>> AmountColumn;
+
+//Copies share the column until one of them writes, as ChunkedSeries does with its chunks.
+//The non-const accessors take an own copy first, so concurrent writers have to detach before they start.
+struct SharedAmountColumn
+{
+    typedef Amount_t value_type;
+
+    SharedAmountColumn() : column(std::make_shared<AmountColumn>()) {}
+
+    size_t size() const { return column->size(); }
+    Amount_t const& operator[](size_t idx) const { return (*column)[idx]; }
+    Amount_t& operator[](size_t idx) { return provideOwn()[idx]; }
+    Amount_t const* data() const { return column->data(); }
+    Amount_t* data() { return provideOwn().data(); }
+    void resize(size_t size) { provideOwn().resize(size); }
+    void swap(SharedAmountColumn& other) { column.swap(other.column); }
+
+    AmountColumn& provideOwn() {
+        if (!isSoleOwner(column)) {
+            column = std::make_shared<AmountColumn>(*column);
+        }
+        return *column;
+    }
+
+private:
+    std::shared_ptr<AmountColumn> column;
+};
+
+//Structure of arrays: every good of every actor in one contiguous column.
+//The utility column is derived, it is kept up to date by the trades.
+//Copies are cheap, the columns are copied by the first write of a copy.
+struct ActorStore
+{
+    SharedAmountColumn q1, q2;
+    SharedAmountColumn utility;
+
+    void resize(size_t numActors);
+    //before writing from several threads
+    void detach();
+    size_t size() const { return q1.size(); }
+
+    SharedAmountColumn& column(size_t goodIdx) { return goodIdx == 0 ? q1 : q2; }
+    SharedAmountColumn const& column(size_t goodIdx) const { return goodIdx == 0 ? q1 : q2; }
+};
+
+#endif // ACTORSTORE_H
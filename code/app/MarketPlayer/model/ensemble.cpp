@@ -0,0 +1,86 @@
+#include "ensemble.h"
+#include "model.h"
+
+#include <cmath>
+
+RunningMoments::RunningMoments()
+    : count(0)
+    , mean(0.0)
+    , squaredDeviations(0.0)
+{}
+
+void RunningMoments::add(Amount_t value)
+{
+    ++count;
+    Amount_t const delta = value - mean;
+    mean += delta / count;
+    squaredDeviations += delta * (value - mean);
+}
+
+Amount_t RunningMoments::calculateVariance() const
+{
+    return count > 1 ? squaredDeviations / (count - 1) : 0.0;
+}
+
+Amount_t RunningMoments::calculateStandardError() const
+{
+    return count > 1 ? std::sqrt(calculateVariance() / count) : 0.0;
+}
+
+Ensemble::Ensemble()
+    : numRuns(0)
+{}
+
+void Ensemble::reset()
+{
+    rounds.clear();
+    numRuns = 0;
+}
+
+void Ensemble::addRun(const std::vector<RoundValues> &run)
+{
+    if (run.size() > rounds.size()) {
+        rounds.resize(run.size());
+    }
+    for (size_t round = 0; round < run.size(); ++round) {
+        for (size_t series = 0; series < NumSeries; ++series) {
+            rounds[round][series].add(run[round][series]);
+        }
+    }
+    ++numRuns;
+}
+
+EnsembleBand Ensemble::calculateBand(Series series, double z) const
+{
+    EnsembleBand band;
+    for (ResourceDataPair* data : {&band.mean, &band.lower, &band.upper}) {
+        data->resize(rounds.size());
+    }
+    for (size_t round = 0; round < rounds.size(); ++round) {
+        RunningMoments const& moments = rounds[round][series];
+        Amount_t const halfWidth = z * moments.calculateStandardError();
+        band.mean.x[round] = band.lower.x[round] = band.upper.x[round] = round;
+        band.mean.y[round] = moments.getMean();
+        band.lower.y[round] = moments.getMean() - halfWidth;
+        band.upper.y[round] = moments.getMean() + halfWidth;
+    }
+    return band;
+}
+
+Ensemble::RoundValues Ensemble::takeLastRound(const History &history)
+{
+    size_t const last = history.getNumRetained() - 1;
+    RoundValues values;
+    values[Q1Traded] = history.q1Traded[last];
+    values[Q2Traded] = history.q2Traded[last];
+    values[NumSuccessful] = history.numSuccessful[last];
+    values[SumUtilities] = history.sumUtilities[last];
+    values[WealthDeviation] = history.wealthDeviation[last];
+    values[WealthGini] = history.wealthGini[last];
+    values[WealthP10] = history.wealthP10[last];
+    values[WealthP50] = history.wealthP50[last];
+    values[WealthP90] = history.wealthP90[last];
+    values[WealthP99] = history.wealthP99[last];
+    values[WealthTopShare] = history.wealthTopShare[last];
+    return values;
+}
@@ -0,0 +1,66 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <array>
+#include <vector>
+
+#include "modelutils.h"
+
+struct History;
+
+//Mean and variance of a value over runs, folded in one value at a time (Welford's method),
+//so the values themselves need not be kept.
+struct RunningMoments
+{
+    RunningMoments();
+    void add(Amount_t value);
+
+    size_t getCount() const { return count; }
+    Amount_t getMean() const { return mean; }
+    Amount_t calculateVariance() const;
+    Amount_t calculateStandardError() const;
+
+private:
+    size_t count;
+    Amount_t mean;
+    Amount_t squaredDeviations;
+};
+
+struct EnsembleBand
+{
+    ResourceDataPair mean, lower, upper;
+};
+
+//Per-round statistics of the history series over runs of one configuration with different seeds.
+//Only the accumulators are kept: memory grows with the rounds, not with the runs.
+//Round t aggregates the runs that reached it, a run which stopped earlier adds nothing beyond its end.
+struct Ensemble
+{
+    enum Series {
+        Q1Traded, Q2Traded, NumSuccessful, SumUtilities, WealthDeviation,
+        WealthGini, WealthP10, WealthP50, WealthP90, WealthP99, WealthTopShare,
+        NumSeries
+    };
+    typedef std::array<Amount_t, NumSeries> RoundValues;
+
+    Ensemble();
+    void reset();
+    //run[t] holds the values of round t
+    void addRun(std::vector<RoundValues> const& run);
+
+    size_t getNumRuns() const { return numRuns; }
+    size_t getNumRounds() const { return rounds.size(); }
+    RunningMoments const& getMoments(size_t round, Series series) const { return rounds[round][series]; }
+
+    //mean -/+ z standard errors, with the default z the 95% confidence interval of the mean
+    EnsembleBand calculateBand(Series series, double z = 1.96) const;
+
+    //values of the newest round of the history, which retention never drops
+    static RoundValues takeLastRound(History const& history);
+
+private:
+    std::vector<std::array<RunningMoments, NumSeries>> rounds;
+    size_t numRuns;
+};
+
+#endif // ENSEMBLE_H
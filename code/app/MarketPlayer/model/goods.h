@@ -0,0 +1,219 @@
+#ifndef GOODS_H
+#define GOODS_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+#include "modelutils.h"
+
+//Economies of NumGoods goods, the number fixed at compile time.
+//Loops over the goods go through forEachGood, which unrolls them: with the index a constant,
+//a good costs as much as a named field like Position::q1.
+
+template<size_t GoodIdx, size_t NumGoods>
+struct GoodsLoop
+{
+    template<typename Body>
+    static void run(Body& body) {
+        body(GoodIdx);
+        GoodsLoop<GoodIdx + 1, NumGoods>::run(body);
+    }
+};
+
+template<size_t NumGoods>
+struct GoodsLoop<NumGoods, NumGoods>
+{
+    template<typename Body>
+    static void run(Body&) {}
+};
+
+//body(goodIdx) for each good in order
+template<size_t NumGoods, typename Body>
+void forEachGood(Body body)
+{
+    GoodsLoop<0, NumGoods>::run(body);
+}
+
+//Position of an actor, or any bundle of the goods
+template<size_t NumGoods>
+struct Goods
+{
+    std::array<Amount_t, NumGoods> q;
+
+    Amount_t& operator[](size_t goodIdx) { return q[goodIdx]; }
+    Amount_t operator[](size_t goodIdx) const { return q[goodIdx]; }
+
+    Goods operator-(Goods const& other) const {
+        Goods result;
+        forEachGood<NumGoods>([&](size_t idx) { result.q[idx] = q[idx] - other.q[idx]; });
+        return result;
+    }
+    Goods operator+(Goods const& other) const {
+        Goods result;
+        forEachGood<NumGoods>([&](size_t idx) { result.q[idx] = q[idx] + other.q[idx]; });
+        return result;
+    }
+    Goods operator*(double const& factor) const {
+        Goods result;
+        forEachGood<NumGoods>([&](size_t idx) { result.q[idx] = q[idx] * factor; });
+        return result;
+    }
+    Amount_t sumAbs() const {
+        Amount_t sum = 0.0;
+        forEachGood<NumGoods>([&](size_t idx) { sum += std::abs(q[idx]); });
+        return sum;
+    }
+};
+
+//Cobb-Douglas utility, the product of q_i^alfa_i. For two goods it evaluates the closed forms of Utility,
+//so the results are bit-identical to it. Equal exponents of more goods take one pow of the product.
+template<size_t NumGoods>
+struct CobbDouglasUtility
+{
+    static_assert(NumGoods >= 2, "trading needs at least two goods");
+
+    CobbDouglasUtility();
+    explicit CobbDouglasUtility(std::array<double, NumGoods> const& alfas);
+
+    std::array<double, NumGoods> const& getAlfas() const { return alfas; }
+
+    Amount_t compute(Goods<NumGoods> const& position) const;
+    //Where the indifference surface through position meets the contract curve of a pair with the given sums.
+    //Both actors having the same utility, the contract curve is the diagonal of the box: t * sums.
+    Goods<NumGoods> computeParetoIntersection(Goods<NumGoods> const& position, Goods<NumGoods> const& sums) const;
+
+private:
+    //the rest is derived from them, so they are set by the constructor only
+    std::array<double, NumGoods> alfas;
+    //alfa_i / sum of the alfas
+    std::array<double, NumGoods> weights;
+    bool equalExponents;
+    bool equalHalves;
+    bool constantReturns;
+};
+
+template<size_t NumGoods>
+CobbDouglasUtility<NumGoods>::CobbDouglasUtility()
+{
+    std::array<double, NumGoods> equalAlfas;
+    equalAlfas.fill(1.0 / NumGoods);
+    *this = CobbDouglasUtility(equalAlfas);
+}
+
+template<size_t NumGoods>
+CobbDouglasUtility<NumGoods>::CobbDouglasUtility(std::array<double, NumGoods> const& alfas)
+    : alfas(alfas)
+    , equalExponents(true)
+    , equalHalves(NumGoods == 2)
+{
+    double sumAlfas = 0.0;
+    forEachGood<NumGoods>([&](size_t idx) {
+        sumAlfas += alfas[idx];
+        equalExponents = equalExponents && alfas[idx] == alfas[0];
+        equalHalves = equalHalves && alfas[idx] == 0.5;
+    });
+    constantReturns = sumAlfas == 1.0;
+    forEachGood<NumGoods>([&](size_t idx) { weights[idx] = alfas[idx] / sumAlfas; });
+}
+
+template<size_t NumGoods>
+Amount_t CobbDouglasUtility<NumGoods>::compute(Goods<NumGoods> const& position) const
+{
+    if (NumGoods == 2 && equalHalves) {
+        return std::sqrt(position[0]*position[1]);
+    } else if (NumGoods == 2 && constantReturns) {
+        return position[0] > 0.0 ? position[0]*pow(position[1]/position[0], alfas[1]) : 0.0;
+    }
+    bool allPositive = true;
+    forEachGood<NumGoods>([&](size_t idx) { allPositive = allPositive && position[idx] > 0.0; });
+    if (!allPositive) {
+        return 0.0;
+    }
+    if (NumGoods > 2 && equalExponents) {
+        Amount_t product = 1.0;
+        forEachGood<NumGoods>([&](size_t idx) { product *= position[idx]; });
+        return pow(product, alfas[0]);
+    }
+    Amount_t exponent = 0.0;
+    forEachGood<NumGoods>([&](size_t idx) { exponent += alfas[idx]*log(position[idx]); });
+    return exp(exponent);
+}
+
+//On the diagonal the utility is t^(sum of alfas) * U(sums), so t is the weighted geometric mean of position/sums.
+//Two goods take the closed form of Utility::computeParetoIntersection.
+template<size_t NumGoods>
+Goods<NumGoods> CobbDouglasUtility<NumGoods>::computeParetoIntersection(Goods<NumGoods> const& position,
+                                                                         Goods<NumGoods> const& sums) const
+{
+    Goods<NumGoods> intersection;
+    if (NumGoods == 2) {
+        Amount_t const ratio = (sums[0]*position[1]) / (sums[1]*position[0]);
+        intersection[0] = position[0] * (equalExponents ? std::sqrt(ratio) : pow(ratio, weights[1]));
+        intersection[1] = intersection[0] * sums[1]/sums[0];
+        return intersection;
+    }
+    Amount_t share = 0.0;
+    if (equalExponents) {
+        Amount_t product = 1.0;
+        forEachGood<NumGoods>([&](size_t idx) { product *= position[idx] / sums[idx]; });
+        share = pow(product, 1.0 / NumGoods);
+    } else {
+        Amount_t exponent = 0.0;
+        forEachGood<NumGoods>([&](size_t idx) { exponent += weights[idx]*log(position[idx] / sums[idx]); });
+        share = exp(exponent);
+    }
+    forEachGood<NumGoods>([&](size_t idx) { intersection[idx] = share * sums[idx]; });
+    return intersection;
+}
+
+//A pair of actors meeting, the generalization of EdgeworthSituation with its strategies fixed:
+//the offer is a uniform point of the contract curve between the surfaces through the two actors
+//(RandomParetoOfferStrategy), accepted if actor 1 gains no more than actor 2 (HigherGainAcceptanceStrategy).
+//Everything is computed once, in the constructor.
+template<size_t NumGoods>
+struct BilateralSituation
+{
+    Goods<NumGoods> const actor1, actor2;
+    Goods<NumGoods> const sums;
+    Goods<NumGoods> const curve1ParetoIntersection, curve2ParetoIntersection;
+    Goods<NumGoods> const result;
+    Amount_t const newUtility1, newUtility2;
+    bool const accepted;
+    bool const successful;
+
+    BilateralSituation(CobbDouglasUtility<NumGoods> const& utility,
+                       Goods<NumGoods> const& actor1, Amount_t utility1,
+                       Goods<NumGoods> const& actor2, Amount_t utility2,
+                       Amount_t minSumTrade, URNG& rng);
+
+    Goods<NumGoods> calculateActor2Result() const { return sums - result; }
+
+private:
+    static Goods<NumGoods> propose(Goods<NumGoods> const& p1, Goods<NumGoods> const& p2, URNG& rng) {
+        double const factor = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return p1 + (p2 - p1) * factor;
+    }
+};
+
+template<size_t NumGoods>
+BilateralSituation<NumGoods>::BilateralSituation(CobbDouglasUtility<NumGoods> const& utility,
+                                                 Goods<NumGoods> const& actor1, Amount_t utility1,
+                                                 Goods<NumGoods> const& actor2, Amount_t utility2,
+                                                 Amount_t minSumTrade, URNG& rng)
+    : actor1(actor1)
+    , actor2(actor2)
+    , sums(actor1 + actor2)
+    , curve1ParetoIntersection(utility.computeParetoIntersection(actor1, sums))
+    //computed in the coordinates of actor 2, then flipped into the box of actor 1
+    , curve2ParetoIntersection(sums - utility.computeParetoIntersection(actor2, sums))
+    , result(propose(curve1ParetoIntersection, curve2ParetoIntersection, rng))
+    , newUtility1(utility.compute(result))
+    , newUtility2(utility.compute(sums - result))
+    , accepted(newUtility1 - utility1 <= newUtility2 - utility2)
+    , successful(accepted && (result - actor1).sumAbs() >= minSumTrade)
+{
+}
+
+#endif // GOODS_H
@@ -0,0 +1,219 @@
+#ifndef GOODSECONOMY_H
+#define GOODSECONOMY_H
+
+#include <array>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "goods.h"
+#include "model.h"
+#include "threadpool.h"
+
+//Trading between random pairs of actors with NumGoods goods, see BilateralSituation.
+//It pairs the actors by Simulation::Progress, draws the streams of Simulation and trades by its blocks,
+//so with two goods the actors end up exactly as in Simulation with the random pareto offer
+//and the higher gain acceptance, seed for seed. calculateSumUtilities adds up in actor order,
+//so it does not depend on the build flags either, but it is not the sum of the history of Simulation.
+//It keeps no history and no distributions, only the counters of the last round.
+template<size_t NumGoods>
+struct GoodsEconomy
+{
+    struct RoundInfo
+    {
+        void reset();
+        void merge(RoundInfo const& other);
+        std::array<Amount_t, NumGoods> traded;
+        Amount_t numSuccessful;
+    };
+
+    GoodsEconomy();
+
+    bool setup(URNG::result_type seed, size_t numActors,
+               std::array<Amount_t, NumGoods> const& amounts, std::array<double, NumGoods> const& alfas,
+               double minTradeFactor);
+    void performNextRound();
+    //0 or 1: the calling thread only. The outcome does not depend on it.
+    void setNumThreads(size_t numThreads);
+
+    size_t getNumActors() const { return numActors; }
+    //rounds traded since the setup
+    size_t getNumRounds() const { return round - 1; }
+    RoundInfo const& getLastRoundInfo() const { return lastRoundInfo; }
+    CobbDouglasUtility<NumGoods> const& getUtility() const { return utility; }
+    Amount_t getMinSumTrade() const { return minSumTrade; }
+    Goods<NumGoods> getActor(size_t actorIdx) const;
+    Amount_t getActorUtility(size_t actorIdx) const { return utilities[actorIdx]; }
+    AmountColumn const& getColumn(size_t goodIdx) const { return columns[goodIdx]; }
+    AmountColumn const& getUtilities() const { return utilities; }
+    Amount_t calculateSumUtilities() const;
+    //of the last round, for the stopping rules
+    RoundOutcome getLastRoundOutcome(double seconds) const;
+
+private:
+    URNG createStream(Simulation::StreamKind kind, size_t roundIdx, size_t idx) const;
+    void tradePairs(size_t beginPair, size_t endPair, RoundInfo& info);
+    ThreadPool& provideThreadPool();
+
+    URNG::result_type seed;
+    size_t numActors;
+    //the round being traded, 0 is the initial state as in the history of Simulation
+    size_t round;
+    CobbDouglasUtility<NumGoods> utility;
+    std::array<Amount_t, NumGoods> amounts;
+    std::array<AmountColumn, NumGoods> columns;
+    AmountColumn utilities;
+    Simulation::Progress progress;
+    Amount_t minSumTrade;
+    RoundInfo lastRoundInfo;
+    std::vector<RoundInfo> blockInfos;
+    size_t numThreads;
+    std::unique_ptr<ThreadPool> threadPool;
+};
+
+template<size_t NumGoods>
+void GoodsEconomy<NumGoods>::RoundInfo::reset()
+{
+    traded.fill(0.0);
+    numSuccessful = 0;
+}
+
+template<size_t NumGoods>
+void GoodsEconomy<NumGoods>::RoundInfo::merge(const RoundInfo &other)
+{
+    forEachGood<NumGoods>([&](size_t idx) { traded[idx] += other.traded[idx]; });
+    numSuccessful += other.numSuccessful;
+}
+
+template<size_t NumGoods>
+GoodsEconomy<NumGoods>::GoodsEconomy()
+    : seed(0)
+    , numActors(0)
+    , round(1)
+    , minSumTrade(0.0)
+    , numThreads(0)
+{
+    lastRoundInfo.reset();
+}
+
+template<size_t NumGoods>
+bool GoodsEconomy<NumGoods>::setup(URNG::result_type seed, size_t numActors,
+                                   std::array<Amount_t, NumGoods> const& amounts,
+                                   std::array<double, NumGoods> const& alfas, double minTradeFactor)
+{
+    if (numActors%2 != 0) return false;
+    this->seed = seed;
+    this->numActors = numActors;
+    round = 1;
+    utility = CobbDouglasUtility<NumGoods>(alfas);
+    this->amounts = amounts;
+    URNG shuffleRng = createStream(Simulation::ShuffleStream, round, 0);
+    progress.setup(numActors, shuffleRng);
+    Amount_t total = 0.0;
+    for (size_t idx = 0; idx < NumGoods; ++idx) {
+        URNG resourceRng = createStream(Simulation::ResourceStream, 0, idx);
+        Simulation::setupResources(columns[idx], amounts[idx], numActors, resourceRng);
+        total += amounts[idx];
+    }
+    minSumTrade = total / static_cast<Amount_t>(numActors) * minTradeFactor;
+    utilities.resize(numActors);
+    for (size_t actorIdx = 0; actorIdx < numActors; ++actorIdx) {
+        utilities[actorIdx] = utility.compute(getActor(actorIdx));
+    }
+    lastRoundInfo.reset();
+    return true;
+}
+
+template<size_t NumGoods>
+Goods<NumGoods> GoodsEconomy<NumGoods>::getActor(size_t actorIdx) const
+{
+    Goods<NumGoods> actor;
+    forEachGood<NumGoods>([&](size_t idx) { actor[idx] = columns[idx][actorIdx]; });
+    return actor;
+}
+
+template<size_t NumGoods>
+Amount_t GoodsEconomy<NumGoods>::calculateSumUtilities() const
+{
+    return std::accumulate(utilities.begin(), utilities.end(), Amount_t(0.0));
+}
+
+//the traded share is the mean over the goods, as Simulation counts it for two
+template<size_t NumGoods>
+RoundOutcome GoodsEconomy<NumGoods>::getLastRoundOutcome(double seconds) const
+{
+    Amount_t tradedShare = 0.0;
+    forEachGood<NumGoods>([&](size_t idx) { tradedShare += lastRoundInfo.traded[idx] / amounts[idx]; });
+    return RoundOutcome{getNumRounds(), lastRoundInfo.numSuccessful, tradedShare / NumGoods,
+                        calculateSumUtilities(), seconds};
+}
+
+template<size_t NumGoods>
+URNG GoodsEconomy<NumGoods>::createStream(Simulation::StreamKind kind, size_t roundIdx, size_t idx) const
+{
+    return Simulation::createStream(seed, kind, roundIdx, idx);
+}
+
+//Pairs are disjoint, the blocks are merged in order, as in Simulation::performRemainingTrades
+template<size_t NumGoods>
+void GoodsEconomy<NumGoods>::performNextRound()
+{
+    size_t const numPairs = progress.getNum();
+    blockInfos.resize(Simulation::countBlocks(0, numPairs));
+    Simulation::tradeBlocks(provideThreadPool(), 0, numPairs, [this](size_t blockIdx, size_t beginPair, size_t endPair) {
+        RoundInfo& info = blockInfos[blockIdx];
+        info.reset();
+        tradePairs(beginPair, endPair, info);
+    });
+    lastRoundInfo.reset();
+    for (auto const& info : blockInfos) {
+        lastRoundInfo.merge(info);
+    }
+    ++round;
+    URNG shuffleRng = createStream(Simulation::ShuffleStream, round, 0);
+    progress.finishRound(shuffleRng);
+}
+
+template<size_t NumGoods>
+void GoodsEconomy<NumGoods>::tradePairs(size_t beginPair, size_t endPair, RoundInfo& info)
+{
+    for (size_t pairIdx = beginPair; pairIdx < endPair; ++pairIdx) {
+        size_t actor1Idx, actor2Idx;
+        std::tie(actor1Idx, actor2Idx) = progress.getPair(pairIdx);
+        URNG rng = createStream(Simulation::TradeStream, round, pairIdx);
+        BilateralSituation<NumGoods> const situation(utility, getActor(actor1Idx), utilities[actor1Idx],
+                                                     getActor(actor2Idx), utilities[actor2Idx], minSumTrade, rng);
+        if (!situation.successful) {
+            continue;
+        }
+        Goods<NumGoods> const actor2Result = situation.calculateActor2Result();
+        forEachGood<NumGoods>([&](size_t idx) {
+            info.traded[idx] += std::abs(situation.actor1[idx] - situation.result[idx]);
+            columns[idx][actor1Idx] = situation.result[idx];
+            columns[idx][actor2Idx] = actor2Result[idx];
+        });
+        utilities[actor1Idx] = situation.newUtility1;
+        utilities[actor2Idx] = situation.newUtility2;
+        info.numSuccessful += 1;
+    }
+}
+
+template<size_t NumGoods>
+void GoodsEconomy<NumGoods>::setNumThreads(size_t numThreads)
+{
+    if (this->numThreads != numThreads) {
+        this->numThreads = numThreads;
+        threadPool.reset();
+    }
+}
+
+template<size_t NumGoods>
+ThreadPool& GoodsEconomy<NumGoods>::provideThreadPool()
+{
+    if (!threadPool) {
+        threadPool.reset(new ThreadPool(std::max<size_t>(numThreads, 1)));
+    }
+    return *threadPool;
+}
+
+#endif // GOODSECONOMY_H
@@ -1,6 +1,3 @@
-#include "mainwindow.h"
-#include "ui_mainwindow.h"
-
 #include <ctime>
 #include <random>
 #include <algorithm>
@@ -14,11 +11,13 @@
 #include <vector>
 #include <tuple>
 #include <list>
+#include <limits>
 
 #include <QVector>
 
-#include "qcustomplot.h"
 #include "model.h"
+#include "actorkernels.h"
+#include "tradeengine.h"
 
 URNG globalUrng;
 
@@ -32,8 +31,37 @@ template<typename E>
 using vector = QVector<E>;
 
 
+Utility::Utility()
+    : Utility(0.5, 0.5)
+{}
+
+Utility::Utility(double alfa1, double alfa2)
+    : alfa1(alfa1)
+    , alfa2(alfa2)
+    , curveExponent(alfa1/alfa2)
+    , intersectionExponent(alfa2/(alfa1+alfa2))
+    , equalExponents(alfa1 == alfa2)
+    , equalHalves(alfa1 == 0.5 && alfa2 == 0.5)
+    , constantReturns(alfa1 + alfa2 == 1.0)
+{}
+
 Amount_t Utility::compute(Amount_t q1, Amount_t q2) const {
-    return pow(q1, alfa1)*pow(q2, alfa2);
+    if (equalHalves) {
+        return std::sqrt(q1*q2);
+    } else if (constantReturns) {
+        return q1 > 0.0 ? q1*pow(q2/q1, alfa2) : 0.0;
+    }
+    return q1 > 0.0 && q2 > 0.0 ? exp(alfa1*log(q1) + alfa2*log(q2)) : 0.0;
+}
+
+//implicit hack of linear contract curve: q2 = q1 * q2Sum/q1Sum.
+//Meeting the curve q2 = fixQ2 * (fixQ1/q1)^(alfa1/alfa2) there gives
+//q1 = fixQ1 * (q1Sum*fixQ2 / (q2Sum*fixQ1))^(alfa2/(alfa1+alfa2)).
+Position Utility::computeParetoIntersection(Amount_t q1, Amount_t q2, Amount_t q1Sum, Amount_t q2Sum) const
+{
+    Amount_t const ratio = (q1Sum*q2) / (q2Sum*q1);
+    Amount_t const intersectionQ1 = q1 * (equalExponents ? std::sqrt(ratio) : pow(ratio, intersectionExponent));
+    return Position{intersectionQ1, intersectionQ1 * q2Sum/q1Sum};
 }
 
 IndifferenceCurve::IndifferenceCurve(Utility utility, Amount_t q1, Amount_t q2)
@@ -42,20 +70,7 @@ IndifferenceCurve::IndifferenceCurve(Utility utility, Amount_t q1, Amount_t q2)
 {}
 
 Amount_t IndifferenceCurve::getQ2(Amount_t q1) const {
-    return fixP.q2 * pow(fixP.q1/q1, utility.alfa1/utility.alfa2);
-}
-
-EdgeworthSituation::EdgeworthSituation(const Simulation& simulation, const size_t actor1Idx, const size_t actor2Idx,
-        AbstractOfferStrategy& offerStrategy, AbstractAcceptanceStrategy& acceptanceStrategy, URNG& rng)
-    : actor1(simulation, actor1Idx)
-    , actor2(simulation, actor2Idx)
-    , curve1(simulation.utility, actor1.q1, actor1.q2)
-    , curve2(simulation.utility, actor2.q1, actor2.q2)
-    , q1Sum(actor1.q1 + actor2.q1)
-    , q2Sum(actor1.q2 + actor2.q2)
-    , result(offerStrategy.propose(*this, rng))
-    , successful(isItSuccessful(acceptanceStrategy.consider(*this), simulation.getMinSumTrade()))
-{
+    return fixP.q2 * pow(fixP.q1/q1, utility.getCurveExponent());
 }
 
 bool EdgeworthSituation::isItSuccessful(bool consideration, Amount_t minimum) const
@@ -79,25 +94,18 @@ CurveFunction EdgeworthSituation::getParetoSetFunction() const {
     return [this](double q1){ return q1 * q2Sum/q1Sum; };
 }
 
-//implicit hack of linear contract-curve
-Amount_t EdgeworthSituation::calculateParetoIntersectionQ1(const IndifferenceCurve& curve) const {
-    double const alfa1 = curve.utility.alfa1;
-    double const alfa2 = curve.utility.alfa2;
-    return pow(q1Sum/q2Sum * curve.fixP.q2 * pow(curve.fixP.q1, alfa1/alfa2),
-               alfa2/(alfa1+alfa2));
-}
-
 Position EdgeworthSituation::calculateCurve1ParetoIntersection() const {
-    Amount_t const q1 = calculateParetoIntersectionQ1(curve1);
-    Amount_t const q2 = getCurve1Function()(q1);
-    return Position{q1, q2};
+    return curve1ParetoIntersection;
 }
 
-//implicit hack of linear contract curve
 Position EdgeworthSituation::calculateCurve2ParetoIntersection() const {
-    Amount_t const q1 = q1Sum - calculateParetoIntersectionQ1(curve2);
-    Amount_t const q2 = getCurve2Function()(q1);
-    return Position{q1, q2};
+    return curve2ParetoIntersection;
+}
+
+//computed in the coordinates of actor 2, then flipped into the box of actor 1
+Position EdgeworthSituation::calculateParetoIntersectionOfActor2() const {
+    Position const intersection = curve2.utility.computeParetoIntersection(actor2.q1, actor2.q2, q1Sum, q2Sum);
+    return Position{q1Sum - intersection.q1, q2Sum - intersection.q2};
 }
 
 Position EdgeworthSituation::calculateActor2Result() const
@@ -105,20 +113,20 @@ Position EdgeworthSituation::calculateActor2Result() const
     return {q1Sum - result.q1, q2Sum - result.q2};
 }
 
-Amount_t EdgeworthSituation::calculateOriginalUtility(const Simulation::ActorConstRef &actor) const
+//kept up to date in the actor store by the trades
+Amount_t EdgeworthSituation::calculateOriginalUtility(const Simulation::ActorValues &actor) const
 {
-    return curve1.utility.compute(actor.q1, actor.q2);
+    return actor.utility;
 }
 
 Amount_t EdgeworthSituation::calculateNewUtilityActor1() const
 {
-    return curve1.utility.compute(result.q1, result.q2);
+    return newUtility1;
 }
 
 Amount_t EdgeworthSituation::calculateNewUtilityActor2() const
 {
-    Position const actor2NewPos = calculateActor2Result();
-    return curve2.utility.compute(actor2NewPos.q1, actor2NewPos.q2);
+    return newUtility2;
 }
 
 void Simulation::Progress::setup(size_t numActors, URNG& rng) {
@@ -134,10 +142,27 @@ tuple<size_t, size_t> Simulation::Progress::getCurrentPair() const
     return make_tuple(permutation[actIdx], permutation[actIdx+1]);
 }
 
+tuple<size_t, size_t> Simulation::Progress::getPair(size_t pairIdx) const
+{
+    return make_tuple(permutation[2*pairIdx], permutation[2*pairIdx+1]);
+}
+
 bool Simulation::Progress::advance(URNG& rng)
 {
     restarted = false;
     actIdx += 2;
+    return restartIfFinished(rng);
+}
+
+bool Simulation::Progress::finishRound(URNG &rng)
+{
+    restarted = false;
+    actIdx = permutation.size();
+    return restartIfFinished(rng);
+}
+
+bool Simulation::Progress::restartIfFinished(URNG &rng)
+{
     bool const finished = isFinished();
     if (finished) {
         shufflePermutation(rng);
@@ -156,21 +181,42 @@ bool Simulation::Progress::isFinished() const
     return actIdx == permutation.size();
 }
 
+void Simulation::Progress::releasePairs()
+{
+    permutation = vector<size_t>();
+}
+
 Simulation &Simulation::operator=(const Simulation &o)
 {
     seed = o.seed;
-    innerUrng = o.innerUrng;
     history = o.history;
     progress = o.progress;
     utility = o.utility;
-    resources = o.resources;
+    actors = o.actors;
     numActors = o.numActors;
     amounts = o.amounts;
     roundInfo = o.roundInfo;
+    q1Distribution = o.q1Distribution;
+    q2Distribution = o.q2Distribution;
+    utilityDistribution = o.utilityDistribution;
+    wealthDistribution = o.wealthDistribution;
     q2Price = o.q2Price;
     minTradeFactor = o.minTradeFactor;
     maxRoundWithoutTrade = o.maxRoundWithoutTrade;
     minSumTrade = o.minSumTrade;
+    if (numThreads != o.numThreads) {
+        threadPool.reset();
+    }
+    numThreads = o.numThreads;
+    blockInfo = o.blockInfo;
+    stoppingCriteria = o.stoppingCriteria;
+    stoppingRule.reset(o.stoppingRule.get() ? o.stoppingRule->clone() : nullptr);
+    histogramSettings = o.histogramSettings;
+    roundProfile.reset();
+    lastRoundProfile.reset();
+    totalProfile.reset();
+    //the pool and the engine are not shared, the copy creates its own on demand
+    tradeEngine.reset();
 
     if (o.offerStrategy.get()) {
         offerStrategy.reset(o.offerStrategy->clone());
@@ -184,18 +230,47 @@ Simulation &Simulation::operator=(const Simulation &o)
     }
 
     //Intentionally reset to zero as this is just a view.
-    //However, warning: if Simulation gets copied while in the middle of a step-by-step Edgeworth,
-    //then (sigh) we will lose the random and the simulation will continue going a different course.
+    //The draws of a pair are keyed, so the copy previews and trades the very same situation.
     previewedSituation.reset();
 
     return *this;
 }
 
-void Simulation::setupResources(vector<Amount_t>& targetResources, const Amount_t sumAmount, const size_t numActors) {
+Simulation::Simulation()
+    : numThreads(0)
+{
+}
+
+//operator= compares the thread counts, so numThreads is set before delegating
+Simulation::Simulation(const Simulation &o)
+    : numThreads(0)
+{
+    *this = o;
+}
+
+Simulation::~Simulation()
+{
+}
+
+//Costs O(buckets + rounds / chunk size), the actor columns and the moments are shared, not copied
+SimulationSnapshot Simulation::takeSnapshot() const
+{
+    return std::make_shared<Simulation const>(*this);
+}
+
+SimulationSnapshot Simulation::takeProgressSnapshot() const
+{
+    auto snapshot = std::make_shared<Simulation>(*this);
+    snapshot->actors = ActorStore();
+    snapshot->progress.releasePairs();
+    return snapshot;
+}
+
+void Simulation::setupResources(AmountColumn& targetResources, const Amount_t sumAmount, const size_t numActors, URNG& rng) {
     targetResources.resize(numActors);
-    std::generate_n(targetResources.begin(), numActors, [this](){
+    std::generate_n(targetResources.begin(), numActors, [&rng](){
         std::uniform_real_distribution<Amount_t> uniformDistribution(0.0, 1.0);
-        return uniformDistribution(innerUrng);
+        return uniformDistribution(rng);
     });
     Amount_t const sumRandom = std::accumulate(targetResources.begin(), targetResources.end(), 0.0);
     double const ratio = sumAmount/sumRandom;
@@ -212,25 +287,33 @@ bool Simulation::setup(
         double minTradeFactor, size_t maxRoundWithoutTrade) {
     if (numActors%2 != 0) return false;
     this->seed = seed;
-    innerUrng.seed(seed);
     history.reset();
     amounts.resize(0);
     amounts.push_back(amountQ1);
     amounts.push_back(amountQ2);
-    resources.resize(amounts.size());
+    actors.resize(numActors);
     this->numActors = numActors;
-    utility.alfa1 = alfa1;
-    utility.alfa2 = alfa2;
+    utility = Utility(alfa1, alfa2);
     this->minTradeFactor = minTradeFactor;
     this->maxRoundWithoutTrade = maxRoundWithoutTrade;
     this->minSumTrade = calculateMinSumTrade(amounts[0], amounts[1], numActors, minTradeFactor);
-    progress.setup(numActors, innerUrng);
+    URNG shuffleRng = createNextShuffleStream();
+    progress.setup(numActors, shuffleRng);
     for (vector<Amount_t>::size_type idx = 0; idx < amounts.size(); ++idx) {
-        setupResources(resources[idx], amounts[idx], numActors);
+        URNG resourceRng = createStream(ResourceStream, 0, idx);
+        setupResources(actors.column(idx).provideOwn(), amounts[idx], numActors, resourceRng);
     }
     q2Price = amounts[0] / amounts[1];
+    //the trades compare against and overwrite the column with Utility::compute, the kernel gives the same bits
+    computeUtilities(utility.getAlfa1(), utility.getAlfa2(), actors.q1.data(), actors.q2.data(), actors.utility.data(), numActors);
+    rebuildDistributions();
     roundInfo.reset();
+    blockInfo.reset();
+    roundProfile.reset();
+    lastRoundProfile.reset();
+    totalProfile.reset();
     saveHistory();
+    restartStoppingRule();
     return true;
 }
 
@@ -238,7 +321,31 @@ EdgeworthSituation Simulation::getNextSituation() const
 {
     size_t actor1Idx, actor2Idx;
     std::tie(actor1Idx, actor2Idx) = progress.getCurrentPair();
-    return EdgeworthSituation(*this, actor1Idx, actor2Idx, *offerStrategy, *acceptanceStrategy, innerUrng);
+    URNG rng = createTradeStream(progress.getDone());
+    return EdgeworthSituation(*this, actor1Idx, actor2Idx, *offerStrategy, *acceptanceStrategy, rng);
+}
+
+URNG Simulation::createStream(StreamKind kind, size_t roundIdx, size_t idx) const
+{
+    return createStream(seed, kind, roundIdx, idx);
+}
+
+URNG Simulation::createStream(URNG::result_type seed, StreamKind kind, size_t roundIdx, size_t idx)
+{
+    uint64_t const key = (static_cast<uint64_t>(kind) << 32) | seed;
+    return URNG(key, static_cast<uint32_t>(roundIdx), static_cast<uint32_t>(idx));
+}
+
+//The round being traded is the one after the last saved moment
+URNG Simulation::createTradeStream(size_t pairIdx) const
+{
+    return createStream(TradeStream, history.size(), pairIdx);
+}
+
+//Shuffles the pairs of the next round
+URNG Simulation::createNextShuffleStream() const
+{
+    return createStream(ShuffleStream, history.size() + 1, 0);
 }
 
 Amount_t Simulation::calculateMinSumTrade(Amount_t sumQ1, Amount_t sumQ2, size_t numActors, Amount_t minTradeFactor)
@@ -249,16 +356,21 @@ Amount_t Simulation::calculateMinSumTrade(Amount_t sumQ1, Amount_t sumQ2, size_t
 EdgeworthSituation const& Simulation::provideNextSituation()
 {
     if (!previewedSituation.get()) {
-        size_t actor1Idx, actor2Idx;
-        std::tie(actor1Idx, actor2Idx) = progress.getCurrentPair();
-        previewedSituation.reset(new EdgeworthSituation(*this, actor1Idx, actor2Idx,
-                                                        *offerStrategy, *acceptanceStrategy, innerUrng));
+        previewedSituation.reset(new EdgeworthSituation(getNextSituation()));
     }
     return *previewedSituation;
 }
 
-Position Simulation::trade(EdgeworthSituation const& situation, ActorRef& actor1, ActorRef& actor2)
+//Touches only the two actors, so disjoint pairs may trade concurrently.
+//The running distributions are updated later from the recorded changes.
+Position Simulation::trade(EdgeworthSituation const& situation, size_t actor1Idx, size_t actor2Idx,
+                           ActorChanges& changes)
 {
+    ActorStore const& before = actors;
+    changes.push_back(ActorChange{actor1Idx, before.q1[actor1Idx], before.q2[actor1Idx], before.utility[actor1Idx]});
+    changes.push_back(ActorChange{actor2Idx, before.q1[actor2Idx], before.q2[actor2Idx], before.utility[actor2Idx]});
+    ActorRef actor1(*this, actor1Idx);
+    ActorRef actor2(*this, actor2Idx);
     Position traded { actor1.q1, actor1.q2 };
     traded = traded - situation.result;
     actor1.q1 = situation.result.q1;
@@ -266,9 +378,91 @@ Position Simulation::trade(EdgeworthSituation const& situation, ActorRef& actor1
     Position actor2NewPos = situation.calculateActor2Result();
     actor2.q1 = actor2NewPos.q1;
     actor2.q2 = actor2NewPos.q2;
+    actors.utility[actor1Idx] = situation.calculateNewUtilityActor1();
+    actors.utility[actor2Idx] = situation.calculateNewUtilityActor2();
     return traded;
 }
 
+//The changes are applied in pair order, each distribution on its own thread,
+//so the running sums do not depend on how the pairs were traded.
+void Simulation::applyActorChanges(const std::vector<ActorChanges> &changeLists)
+{
+    RunningDistribution* const distributions[] = {
+        &q1Distribution, &q2Distribution, &utilityDistribution, &wealthDistribution
+    };
+    size_t const numDistributions = sizeof(distributions) / sizeof(distributions[0]);
+    auto const evaluate = [this](size_t distributionIdx, Amount_t q1, Amount_t q2, Amount_t actorUtility) {
+        switch (distributionIdx) {
+        case 0: return q1;
+        case 1: return q2;
+        case 2: return actorUtility;
+        default: return computeWealth(Position{q1, q2});
+        }
+    };
+    //read only, the const accessors skip the sharing check
+    ActorStore const& current = actors;
+    auto const applyTo = [&](size_t distributionIdx) {
+        RunningDistribution& distribution = *distributions[distributionIdx];
+        for (auto const& changes : changeLists) {
+            for (auto const& change : changes) {
+                size_t const idx = change.actorIdx;
+                distribution.remove(evaluate(distributionIdx, change.q1, change.q2, change.utility));
+                distribution.add(evaluate(distributionIdx, current.q1[idx], current.q2[idx], current.utility[idx]));
+            }
+        }
+    };
+
+    size_t numChanges = 0;
+    for (auto const& changes : changeLists) {
+        numChanges += changes.size();
+    }
+    if (numChanges < pairsPerBlock) {
+        for (size_t distributionIdx = 0; distributionIdx < numDistributions; ++distributionIdx) {
+            applyTo(distributionIdx);
+        }
+    } else {
+        provideThreadPool().parallelFor(numDistributions, applyTo);
+    }
+}
+
+//Linear buckets are an eighth of the mean wide. Log buckets span from a thousandth of the mean
+//to the total, which no actor can exceed.
+HistogramLayout Simulation::createHistogramLayout(Amount_t total) const
+{
+    Amount_t const mean = total / numActors;
+    if (histogramSettings.scale == HistogramLayout::LogScale) {
+        return HistogramLayout::logarithmic(mean / 1000, total, histogramSettings.maxBuckets);
+    } else {
+        return HistogramLayout::linear(mean / 8, histogramSettings.maxBuckets);
+    }
+}
+
+//Fills the four distributions in a single pass over the actors, into the buckets of the last rebuild.
+//The trades keep the sums of the goods, so their means are known up front, the utility of the mean actor
+//stands in for the mean utility. Wealths are evaluated exactly as computeWealth does,
+//so the later removals find their buckets.
+void Simulation::rebuildDistributions()
+{
+    Amount_t const meanQ1 = amounts[0] / numActors;
+    Amount_t const meanQ2 = amounts[1] / numActors;
+    Amount_t const meanWealth = computeWealth(Position{meanQ1, meanQ2});
+    //todo generalize
+    q1Distribution.reset(createHistogramLayout(amounts[0]), meanQ1);
+    q2Distribution.reset(createHistogramLayout(amounts[1]), meanQ2);
+    utilityDistribution.reset(createHistogramLayout(utility.compute(amounts[0],amounts[1])), utility.compute(meanQ1, meanQ2));
+    wealthDistribution.reset(createHistogramLayout(amounts[0] + amounts[1]*q2Price), meanWealth);
+
+    Amount_t const* const q1 = actors.q1.data();
+    Amount_t const* const q2 = actors.q2.data();
+    Amount_t const* const actorUtility = actors.utility.data();
+    for (size_t idx = 0; idx < numActors; ++idx) {
+        q1Distribution.add(q1[idx]);
+        q2Distribution.add(q2[idx]);
+        utilityDistribution.add(actorUtility[idx]);
+        wealthDistribution.add(computeWealth(Position{q1[idx], q2[idx]}));
+    }
+}
+
 Amount_t Simulation::computeWealth(Position position) const
 {
     return position.q1 + position.q2*q2Price;
@@ -281,33 +475,17 @@ void Simulation::saveHistory()
     history.numSuccessful.push(roundInfo.numSuccessful);
 
     auto& moment = history.newMoment();
-
-    //todo generalize
-    Amount_t const q1Resolution = amounts[0] / numActors / 8;
-    moment.q1Distribution.setup(resources[0], q1Resolution);
-
-    Amount_t const q2Resolution = amounts[1] / numActors / 8;
-    moment.q2Distribution.setup(resources[1], q2Resolution);
-
-    Amount_t const utilityResolution = utility.compute(amounts[0],amounts[1]) / numActors / 8;
-    auto const& utilities = computeActors(
-        [this](ActorConstRef const& actor) {
-            return utility.compute(actor.q1, actor.q2);
-        }
-    );
-    moment.utilityDistribution.setup(utilities, utilityResolution);
-    auto sumUtilities = std::accumulate(utilities.begin(), utilities.end(), 0.0);
-    history.sumUtilities.push(sumUtilities);
-
-    Amount_t const wealthResolution = (amounts[0] + amounts[1]*q2Price) / numActors / 8;
-    auto const& wealth = computeActors(
-        [this](ActorConstRef const& actor) {
-            return computeWealth({actor.q1, actor.q2});
-        }
-    );
-    moment.wealthDistribution.setup(wealth, wealthResolution);
+    moment.q1Distribution.setup(q1Distribution);
+    moment.q2Distribution.setup(q2Distribution);
+    moment.utilityDistribution.setup(utilityDistribution);
+    history.sumUtilities.push(utilityDistribution.getSum());
+    moment.wealthDistribution.setup(wealthDistribution);
 
     history.wealthDeviation.push(moment.wealthDistribution.standardDeviation);
+    history.pushInequality(moment.time, wealthDistribution.calculateInequality());
+
+    //the stopping rules look back on consecutive rounds
+    history.applyRetention(getStoppingLookBack());
 }
 
 Amount_t Simulation::getMinSumTrade() const
@@ -317,21 +495,29 @@ Amount_t Simulation::getMinSumTrade() const
 
 bool Simulation::performNextTrade()
 {
+    int64_t const callStart = profileClockNow();
+    size_t const pairIdx = progress.getDone();
     size_t actor1Idx, actor2Idx;
     std::tie(actor1Idx, actor2Idx) = progress.getCurrentPair();
     EdgeworthSituation const& situation = previewedSituation.get() ?
                 *previewedSituation : getNextSituation();
     if (situation.successful) {
-        ActorRef actor1(*this, actor1Idx);
-        ActorRef actor2(*this, actor2Idx);
-        Position traded = trade(situation, actor1, actor2);
-        roundInfo.recordTrade(traded);
+        std::vector<ActorChanges> changeLists(1);
+        blockInfo.recordTrade(trade(situation, actor1Idx, actor2Idx, changeLists.front()));
+        applyActorChanges(changeLists);
     }
+    roundProfile.countPair(situation.accepted, situation.successful);
     previewedSituation.reset();
-    bool const progressFinished = progress.advance(innerUrng);
+    URNG shuffleRng = createNextShuffleStream();
+    bool const progressFinished = progress.advance(shuffleRng);
+    if (progressFinished || (pairIdx + 1) % pairsPerBlock == 0) {
+        roundInfo.merge(blockInfo);
+        blockInfo.reset();
+    }
     if (progressFinished) {
-        saveHistory();
-        roundInfo.reset();
+        closeRound(callStart);
+    } else {
+        roundProfile.addWallTime(profileClockNow() - callStart);
     }
     return progressFinished;
 }
@@ -339,55 +525,310 @@ bool Simulation::performNextTrade()
 void Simulation::performNextRound()
 {
     if (canContinueSimulation()) {
-        while (!performNextTrade());
+        performRemainingTrades();
     }
 }
 
-bool Simulation::canContinueSimulation() const
+void Simulation::setStrategies(unique_ptr<AbstractOfferStrategy> offerStrategy,
+                               unique_ptr<AbstractAcceptanceStrategy> acceptanceStrategy)
 {
-    if (history.size() < maxRoundWithoutTrade) {
-        return true;
-    } else {
-        size_t numZero = 0;
-        size_t const historySize = history.numSuccessful.size();
-        for (size_t numChecked = 0; numChecked < maxRoundWithoutTrade; ++numChecked) {
-            if (history.numSuccessful[historySize-1 - numChecked] == 0) {
-                ++numZero;
-            }
+    this->offerStrategy = std::move(offerStrategy);
+    this->acceptanceStrategy = std::move(acceptanceStrategy);
+    tradeEngine.reset();
+    previewedSituation.reset();
+    if (this->offerStrategy.get() && this->acceptanceStrategy.get()) {
+        tradeEngine = createTradeEngine(*this->offerStrategy, *this->acceptanceStrategy);
+    }
+}
+
+void Simulation::setNumThreads(size_t numThreads)
+{
+    if (this->numThreads != numThreads) {
+        this->numThreads = numThreads;
+        threadPool.reset();
+    }
+}
+
+size_t Simulation::countBlocks(size_t firstPair, size_t numPairs)
+{
+    return (numPairs + pairsPerBlock - 1) / pairsPerBlock - firstPair / pairsPerBlock;
+}
+
+void Simulation::tradeBlocks(ThreadPool& pool, size_t firstPair, size_t numPairs, const BlockTask &tradeBlock)
+{
+    size_t const firstBlock = firstPair / pairsPerBlock;
+    pool.parallelFor(countBlocks(firstPair, numPairs), [&](size_t blockIdx) {
+        size_t const blockStart = std::max(firstPair, (firstBlock + blockIdx) * pairsPerBlock);
+        size_t const blockEnd = std::min(numPairs, (firstBlock + blockIdx + 1) * pairsPerBlock);
+        tradeBlock(blockIdx, blockStart, blockEnd);
+    });
+}
+
+//Pairs of a round are disjoint, so their trades may run concurrently.
+//The blocks are fixed independently of the number of threads and their partial results
+//are merged in block order, which keeps the outcome bit-identical for any thread count
+//and equal to trading the round pair by pair.
+void Simulation::performRemainingTrades()
+{
+    //the previewed situation is traded as is
+    if (previewedSituation.get() && performNextTrade()) {
+        return;
+    }
+    int64_t const callStart = profileClockNow();
+    size_t const firstPair = progress.getDone();
+    size_t const numPairs = progress.getNum();
+    size_t const numBlocks = countBlocks(firstPair, numPairs);
+    std::vector<RoundInfo> blockInfos(numBlocks);
+    std::vector<ActorChanges> blockChanges(numBlocks);
+    std::vector<RoundProfile> blockProfiles(numBlocks);
+    AbstractTradeEngine const& engine = provideTradeEngine();
+    //a snapshot may still share the columns, the blocks must not copy them concurrently
+    actors.detach();
+
+    tradeBlocks(provideThreadPool(), firstPair, numPairs, [&](size_t blockIdx, size_t blockStart, size_t blockEnd) {
+        RoundInfo& info = blockInfos[blockIdx];
+        //a block partly traded step by step continues its partial result
+        if (blockIdx == 0) {
+            info = blockInfo;
+        } else {
+            info.reset();
         }
-        return (numZero < maxRoundWithoutTrade);
+        engine.tradePairs(*this, blockStart, blockEnd, info, blockChanges[blockIdx], blockProfiles[blockIdx]);
+    });
+    int64_t const distributionsStart = profileClockNow();
+    applyActorChanges(blockChanges);
+    roundProfile.addTime(RoundProfile::DistributionsPhase, profileClockNow() - distributionsStart);
+
+    for (auto const& info : blockInfos) {
+        roundInfo.merge(info);
+    }
+    for (auto const& profile : blockProfiles) {
+        roundProfile.merge(profile);
     }
+    blockInfo.reset();
+    URNG shuffleRng = createNextShuffleStream();
+    progress.finishRound(shuffleRng);
+    closeRound(callStart);
 }
 
-vector<Amount_t> Simulation::computeActors(std::function<Amount_t(ActorConstRef const&)> evaluatorFn) const
+void Simulation::closeRound(int64_t callStart)
 {
-    vector<Amount_t> result;
-    result.reserve(numActors);
-    for (size_t actorIdx = 0; actorIdx < numActors; ++actorIdx) {
-        ActorConstRef actor(*this, actorIdx);
-        result.push_back(evaluatorFn(actor));
+    if (history.size() % distributionResyncInterval == 0) {
+        int64_t const rebuildStart = profileClockNow();
+        rebuildDistributions();
+        roundProfile.addTime(RoundProfile::DistributionsPhase, profileClockNow() - rebuildStart);
     }
-    return result;
+    int64_t const saveStart = profileClockNow();
+    saveHistory();
+    int64_t const roundEnd = profileClockNow();
+    roundInfo.reset();
+
+    roundProfile.addTime(RoundProfile::SaveHistoryPhase, roundEnd - saveStart);
+    roundProfile.addWallTime(roundEnd - callStart);
+    roundProfile.numRounds = 1;
+    if (stoppingRule.get()) {
+        stoppingRule->recordRound(getRoundOutcome(history.getNumRetained() - 1, roundProfile.getWallSeconds()));
+    }
+    lastRoundProfile = roundProfile;
+    totalProfile.merge(roundProfile);
+    roundProfile.reset();
+}
+
+//Strategies assigned directly instead of through setStrategies are picked up here
+AbstractTradeEngine const& Simulation::provideTradeEngine()
+{
+    if (!tradeEngine.get() || !tradeEngine->isSelectedFor(offerStrategy.get(), acceptanceStrategy.get())) {
+        tradeEngine = createTradeEngine(*offerStrategy, *acceptanceStrategy);
+    }
+    return *tradeEngine;
 }
 
-History::History(): time(0) {}
+ThreadPool &Simulation::provideThreadPool()
+{
+    if (!threadPool.get()) {
+        threadPool.reset(new ThreadPool(numThreads));
+    }
+    return *threadPool;
+}
+
+bool Simulation::canContinueSimulation() const
+{
+    return !stoppingRule.get() || !stoppingRule->isSatisfied();
+}
+
+void Simulation::setHistogramSettings(const HistogramSettings &settings)
+{
+    histogramSettings = settings;
+}
+
+void Simulation::setStoppingCriteria(const StoppingCriteria &criteria)
+{
+    stoppingCriteria = criteria;
+    if (history.size() > 0) {
+        restartStoppingRule();
+    }
+}
+
+//The rounds the rules look back on are retained in full, replaying them restores the state of the rules
+//(except the wall time, which starts anew)
+void Simulation::restartStoppingRule()
+{
+    stoppingRule = createStoppingRule(maxRoundWithoutTrade, stoppingCriteria);
+    size_t const numRetained = history.getNumRetained();
+    size_t const numReplayed = std::min(numRetained, std::max<size_t>(stoppingRule->getLookBack(), 1));
+    for (size_t idx = numRetained - numReplayed; idx < numRetained; ++idx) {
+        stoppingRule->recordRound(getRoundOutcome(idx, 0.0));
+    }
+}
+
+size_t Simulation::getStoppingLookBack() const
+{
+    return stoppingRule.get() ? stoppingRule->getLookBack() : maxRoundWithoutTrade;
+}
+
+RoundOutcome Simulation::getRoundOutcome(size_t historyIdx, double seconds) const
+{
+    Amount_t const tradedShare = (history.q1Traded[historyIdx] / amounts[0] +
+                                  history.q2Traded[historyIdx] / amounts[1]) / 2;
+    return RoundOutcome{history.getTime(historyIdx), history.numSuccessful[historyIdx],
+                        tradedShare, history.sumUtilities[historyIdx], seconds};
+}
+
+bool RetentionPolicy::keepsAll() const
+{
+    return numRecentRounds == std::numeric_limits<size_t>::max();
+}
+
+RetentionPolicy RetentionPolicy::keepAll()
+{
+    return RetentionPolicy{std::numeric_limits<size_t>::max(), std::vector<Tier>(), 0};
+}
+
+RetentionPolicy RetentionPolicy::tiered(size_t numRecentRounds)
+{
+    std::vector<Tier> tiers;
+    tiers.push_back(Tier{numRecentRounds * 10, 10});
+    tiers.push_back(Tier{numRecentRounds * 100, 100});
+    return RetentionPolicy{numRecentRounds, tiers, 1000};
+}
+
+History::History()
+    : time(0)
+    , retentionPolicy(RetentionPolicy::keepAll())
+    , oldStride(0)
+{}
 
 Moment& History::newMoment()
 {
-    ++time;
     moments.push_back(Moment());
+    moments.back().time = time;
+    ++time;
     return moments.back();
 }
 
+size_t History::getNumRetained() const
+{
+    return moments.size();
+}
+
+size_t History::getTime(size_t idx) const
+{
+    return moments[idx].time;
+}
+
+size_t History::findNearestIdx(size_t time) const
+{
+    return q1Traded.findNearestIdx(time);
+}
+
+void History::setRetentionPolicy(const RetentionPolicy &policy)
+{
+    retentionPolicy = policy;
+    oldStride = policy.tiers.empty() ? 1 : policy.tiers.back().stride;
+}
+
+//Rounds of the recent part are always kept, from there on only the multiples of the stride
+//of the part the round has aged into.
+bool History::isRetained(size_t roundTime, size_t numRecentRounds) const
+{
+    size_t const age = time - 1 - roundTime;
+    size_t ageLimit = numRecentRounds;
+    if (age < ageLimit) {
+        return true;
+    }
+    for (auto const& tier : retentionPolicy.tiers) {
+        ageLimit += tier.numRounds;
+        if (age < ageLimit) {
+            return roundTime % tier.stride == 0;
+        }
+    }
+    return roundTime % oldStride == 0;
+}
+
+//Called after every new round: ages all retained rounds by one and drops the ones that aged out.
+//Costs O(retained), which the policy keeps bounded.
+void History::applyRetention(size_t minRecentRounds)
+{
+    if (retentionPolicy.keepsAll() || time == 0) {
+        return;
+    }
+    size_t const numRecentRounds = std::max(retentionPolicy.numRecentRounds, minRecentRounds);
+    size_t tiersLimit = numRecentRounds;
+    for (auto const& tier : retentionPolicy.tiers) {
+        tiersLimit += tier.numRounds;
+    }
+
+    size_t const numMoments = moments.size();
+    keep.resize(numMoments);
+    for (;;) {
+        size_t numOld = 0;
+        for (size_t idx = 0; idx < numMoments; ++idx) {
+            keep[idx] = isRetained(moments[idx].time, numRecentRounds);
+            if (keep[idx] && time - 1 - moments[idx].time >= tiersLimit) {
+                ++numOld;
+            }
+        }
+        if (numOld <= retentionPolicy.maxOldRounds) {
+            break;
+        }
+        oldStride *= 2;
+    }
+
+    auto const isKept = [this](size_t idx) { return keep[idx] != 0; };
+    if (std::all_of(keep.begin(), keep.end(), [](char kept) { return kept != 0; })) {
+        return;
+    }
+    moments.retainIf(isKept);
+    for (auto series : {&q1Traded, &q2Traded, &numSuccessful, &sumUtilities, &wealthDeviation,
+                        &wealthGini, &wealthP10, &wealthP50, &wealthP90, &wealthP99, &wealthTopShare}) {
+        series->retainIf(isKept);
+    }
+}
+
+//time is the round of the moment the metrics belong to, loaded histories are already thinned
+void History::pushInequality(size_t time, const InequalityMetrics &metrics)
+{
+    wealthGini.push(time, metrics.gini);
+    wealthP10.push(time, metrics.p10);
+    wealthP50.push(time, metrics.p50);
+    wealthP90.push(time, metrics.p90);
+    wealthP99.push(time, metrics.p99);
+    wealthTopShare.push(time, metrics.topShare);
+}
+
 void History::reset()
 {
     time = 0;
+    setRetentionPolicy(retentionPolicy);
     q1Traded.reset();
     q2Traded.reset();
     numSuccessful.reset();
     sumUtilities.reset();
     wealthDeviation.reset();
-    moments.resize(0);
+    for (auto series : {&wealthGini, &wealthP10, &wealthP50, &wealthP90, &wealthP99, &wealthTopShare}) {
+        series->reset();
+    }
+    moments.clear();
 }
 
 size_t History::size() const
@@ -408,3 +849,10 @@ void Simulation::RoundInfo::recordTrade(Position traded)
     q2Traded += std::abs(traded.q2);
     numSuccessful += 1;
 }
+
+void Simulation::RoundInfo::merge(const Simulation::RoundInfo &other)
+{
+    q1Traded += other.q1Traded;
+    q2Traded += other.q2Traded;
+    numSuccessful += other.numSuccessful;
+}
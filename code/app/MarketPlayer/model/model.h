@@ -18,16 +18,43 @@
 
 #include "modelutils.h"
 #include "strategy.h"
+#include "actorstore.h"
+#include "threadpool.h"
+#include "roundprofile.h"
+#include "stoppingrule.h"
 
 using std::tuple;
 using std::unique_ptr;
 
 struct Simulation;
 
+//Cobb-Douglas utility q1^alfa1 * q2^alfa2. Everything derived from the exponents is computed
+//once here, so the trades evaluate closed forms with at most one pow per quantity:
+//square roots for equal halves, q1*(q2/q1)^alfa2 for constant returns, logarithms otherwise.
 struct Utility
 {
-    double alfa1, alfa2;
+    Utility();
+    Utility(double alfa1, double alfa2);
+
+    double getAlfa1() const { return alfa1; }
+    double getAlfa2() const { return alfa2; }
+
     Amount_t compute(Amount_t q1, Amount_t q2) const;
+    //Where the indifference curve through (q1, q2) meets the contract curve of a box with the given sums,
+    //in the coordinates of the same actor
+    Position computeParetoIntersection(Amount_t q1, Amount_t q2, Amount_t q1Sum, Amount_t q2Sum) const;
+    //alfa1/alfa2, the indifference curve is q2 = c * q1^-curveExponent
+    double getCurveExponent() const { return curveExponent; }
+
+private:
+    //the rest is derived from them, so they are set by the constructor only
+    double alfa1, alfa2;
+    double curveExponent;
+    //alfa2/(alfa1+alfa2)
+    double intersectionExponent;
+    bool equalExponents;
+    bool equalHalves;
+    bool constantReturns;
 };
 
 struct IndifferenceCurve
@@ -43,31 +70,84 @@ typedef std::unordered_map<Amount_t, bool, std::hash<Amount_t>, ResourceToleranc
 
 struct Moment
 {
+    size_t time;
     HeavyDistribution q1Distribution, q2Distribution, utilityDistribution, wealthDistribution;
 };
 
+//Which rounds the history keeps: all of the recent ones, then every stride-th round of each tier
+//(each stride divides the next). Beyond the last tier at most maxOldRounds are kept, their stride
+//doubles whenever they would exceed it, so the memory stays bounded however long the run is.
+struct RetentionPolicy
+{
+    struct Tier
+    {
+        size_t numRounds;
+        size_t stride;
+    };
+
+    size_t numRecentRounds;
+    std::vector<Tier> tiers;
+    size_t maxOldRounds;
+
+    bool keepsAll() const;
+
+    static RetentionPolicy keepAll();
+    //recent rounds, then every 10th for 10 times as many rounds, then every 100th
+    static RetentionPolicy tiered(size_t numRecentRounds);
+};
+
+//Moments and series are thinned in lockstep: index idx of each refers to the round getTime(idx).
+//Copies share the moments of the finished rounds, see ChunkedSeries.
 struct History
 {
     History();
     size_t time;
-    vector<Moment> moments;
+    ChunkedSeries<Moment> moments;
     DataTimePair q1Traded, q2Traded, numSuccessful, sumUtilities, wealthDeviation;
+    //estimated from the wealth histogram, see calculateInequality
+    DataTimePair wealthGini, wealthP10, wealthP50, wealthP90, wealthP99, wealthTopShare;
     Moment& newMoment();
     void reset();
     size_t size() const;
+
+    size_t getNumRetained() const;
+    size_t getTime(size_t idx) const;
+    size_t findNearestIdx(size_t time) const;
+
+    RetentionPolicy const& getRetentionPolicy() const { return retentionPolicy; }
+    void setRetentionPolicy(RetentionPolicy const& policy);
+    void applyRetention(size_t minRecentRounds);
+    void pushInequality(size_t time, InequalityMetrics const& metrics);
+
+private:
+    bool isRetained(size_t roundTime, size_t numRecentRounds) const;
+
+    RetentionPolicy retentionPolicy;
+    size_t oldStride;
+    //reused by applyRetention
+    std::vector<char> keep;
+
+    friend struct CheckpointIo;
 };
 
 struct AbstractOfferStrategy;
 struct AbstractAcceptanceStrategy;
+struct AbstractTradeEngine;
+
+//Frozen copy of a simulation. It shares the finished rounds of the history with the simulation.
+typedef std::shared_ptr<Simulation const> SimulationSnapshot;
 
 struct Simulation
 {
-    struct ActorConstRef {
-        Amount_t const& q1;
-        Amount_t const& q2;
-        ActorConstRef(Simulation const& simulation, size_t const idx)
-            : q1(simulation.resources[0][idx])
-            , q2(simulation.resources[1][idx])
+    //Copied, so a situation stays valid without the actor columns it was taken from
+    struct ActorValues {
+        Amount_t const q1;
+        Amount_t const q2;
+        Amount_t const utility;
+        ActorValues(Simulation const& simulation, size_t const idx)
+            : q1(simulation.actors.q1[idx])
+            , q2(simulation.actors.q2[idx])
+            , utility(simulation.actors.utility[idx])
         {}
     };
 
@@ -75,8 +155,8 @@ struct Simulation
         Amount_t& q1;
         Amount_t& q2;
         ActorRef(Simulation& simulation, size_t const idx)
-            : q1(simulation.resources[0][idx])
-            , q2(simulation.resources[1][idx])
+            : q1(simulation.actors.q1[idx])
+            , q2(simulation.actors.q2[idx])
         {}
     };
 
@@ -84,13 +164,18 @@ struct Simulation
     {
         void setup(size_t numActor, URNG &rng);
         tuple<size_t, size_t> getCurrentPair() const;
+        tuple<size_t, size_t> getPair(size_t pairIdx) const;
         bool advance(URNG &rng);
+        bool finishRound(URNG &rng);
         size_t getDone() const { return actIdx / 2; }
         size_t getNum() const { return permutation.size() / 2; }
         bool wasRestarted() const { return restarted; }
+        //keeps the counts of the round only, getNum and the pairs are gone
+        void releasePairs();
 
     private:
         bool isFinished() const;
+        bool restartIfFinished(URNG& rng);
         bool restarted;
 
     private:
@@ -98,24 +183,42 @@ struct Simulation
 
         vector<size_t> permutation;
         vector<size_t>::size_type actIdx;
+
+        friend struct CheckpointIo;
+    };
+
+    //State of an actor before a trade. The running distributions replace it by the current state.
+    struct ActorChange
+    {
+        size_t actorIdx;
+        Amount_t q1, q2, utility;
     };
+    typedef std::vector<ActorChange> ActorChanges;
 
     struct RoundInfo
     {
         void reset();
         void recordTrade(Position traded);
+        void merge(RoundInfo const& other);
         Amount_t q1Traded, q2Traded, numSuccessful;
     };
 
+    //Every random draw is keyed by (seed, kind, round, index), so the draws of a pair
+    //do not depend on which pairs were traded before it or on which thread trades it.
+    enum StreamKind { ResourceStream = 1, ShuffleStream = 2, TradeStream = 3 };
+
     URNG::result_type seed;
-    mutable URNG innerUrng;
     History history;
     Progress progress;
     Utility utility;
-    vector<vector<Amount_t>> resources;
+    ActorStore actors;
     size_t numActors;
     vector<Amount_t> amounts;
     RoundInfo roundInfo;
+    //kept up to date trade by trade, the moments take snapshots of them
+    RunningDistribution q1Distribution, q2Distribution, utilityDistribution, wealthDistribution;
+    //rounds after which the running sums are recomputed from the actors to drop the rounding drift
+    static const size_t distributionResyncInterval = 64;
     double q2Price;
     double minTradeFactor;
     size_t maxRoundWithoutTrade;
@@ -123,15 +226,33 @@ struct Simulation
     unique_ptr<AbstractOfferStrategy> offerStrategy;
     unique_ptr<AbstractAcceptanceStrategy> acceptanceStrategy;
 
-    Simulation(){}
-    Simulation(Simulation const& o) { *this = o; }
+    //Threads trading the pairs of a round (0 or 1: the calling thread only).
+    //The pairs are cut into fixed blocks whose partial results are merged in block order,
+    //so the outcome does not depend on the number of threads.
+    size_t numThreads;
+    static const size_t pairsPerBlock = 1024;
+    typedef std::function<void(size_t blockIdx, size_t beginPair, size_t endPair)> BlockTask;
+    //Blocks of the pairs from firstPair to numPairs, the first one may be partly traded already
+    static size_t countBlocks(size_t firstPair, size_t numPairs);
+    //tradeBlock of every block on the pool, blockIdx counting from the block of firstPair.
+    //GoodsEconomy trades its rounds by the same blocks.
+    static void tradeBlocks(ThreadPool& pool, size_t firstPair, size_t numPairs, BlockTask const& tradeBlock);
+
+    Simulation();
+    Simulation(Simulation const& o);
     Simulation& operator=(Simulation const& o);
+    ~Simulation();
+    SimulationSnapshot takeSnapshot() const;
+    //Without the actors and the pairs of the round: costs nothing to the simulation, which would
+    //copy the shared columns on its next write. It may be shown and saved as history, not continued.
+    SimulationSnapshot takeProgressSnapshot() const;
+    bool hasActors() const { return actors.size() == numActors; }
 
     Amount_t getSumQ1() const { return amounts[0]; }
     Amount_t getSumQ2() const { return amounts[1]; }
     size_t getNumMaxTrade() const { return numActors/2; }
 
-    void setupResources(vector<Amount_t>& targetResources, Amount_t const sumAmount, size_t const numActors);
+    static void setupResources(AmountColumn& targetResources, Amount_t const sumAmount, size_t const numActors, URNG& rng);
     bool setup(
             URNG::result_type seed,
             size_t numActors,
@@ -140,31 +261,77 @@ struct Simulation
             double minTradeFactor, size_t maxRoundWithoutTrade);
     bool performNextTrade();
     void performNextRound();
+    void setNumThreads(size_t numThreads);
+    void setStrategies(unique_ptr<AbstractOfferStrategy> offerStrategy,
+                       unique_ptr<AbstractAcceptanceStrategy> acceptanceStrategy);
     bool canContinueSimulation() const;
+    //Further rules besides maxRoundWithoutTrade, kept by setup like the retention policy.
+    //Setting them mid-run replays the recent history into the new rules.
+    void setStoppingCriteria(StoppingCriteria const& criteria);
+    StoppingCriteria const& getStoppingCriteria() const { return stoppingCriteria; }
+    //Applied by setup and by the next resync of the distributions
+    void setHistogramSettings(HistogramSettings const& settings);
+    HistogramSettings const& getHistogramSettings() const { return histogramSettings; }
+    AbstractStoppingRule const* getStoppingRule() const { return stoppingRule.get(); }
     const EdgeworthSituation &provideNextSituation();
-    Position trade(const EdgeworthSituation &situation, ActorRef& actor1, ActorRef& actor2);
+    //the same situation, computed anew on each call
+    EdgeworthSituation getNextSituation() const;
+    Position trade(const EdgeworthSituation &situation, size_t actor1Idx, size_t actor2Idx, ActorChanges& changes);
+    void applyActorChanges(std::vector<ActorChanges> const& changeLists);
+    HistogramLayout createHistogramLayout(Amount_t total) const;
+    void rebuildDistributions();
 
     Amount_t computeWealth(Position position) const;
-    vector<Amount_t> computeActors(std::function<Amount_t(ActorConstRef const&)> evaluatorFn) const;
     void saveHistory();
     Amount_t getMinSumTrade() const;
+    URNG createStream(StreamKind kind, size_t roundIdx, size_t idx) const;
+    static URNG createStream(URNG::result_type seed, StreamKind kind, size_t roundIdx, size_t idx);
+    URNG createTradeStream(size_t pairIdx) const;
 
     static Amount_t calculateMinSumTrade(Amount_t sumQ1, Amount_t sumQ2, size_t numActors, Amount_t minTradeFactor);
+
+    //Always recorded, see RoundProfile. Not part of the state: copies and checkpoints start them anew.
+    RoundProfile const& getLastRoundProfile() const { return lastRoundProfile; }
+    RoundProfile const& getTotalProfile() const { return totalProfile; }
 private:
     unique_ptr<EdgeworthSituation> previewedSituation;
-    EdgeworthSituation getNextSituation() const;
+    URNG createNextShuffleStream() const;
+    void performRemainingTrades();
+    void closeRound(int64_t callStart);
+    void restartStoppingRule();
+    size_t getStoppingLookBack() const;
+    RoundOutcome getRoundOutcome(size_t historyIdx, double seconds) const;
+    ThreadPool& provideThreadPool();
+    AbstractTradeEngine const& provideTradeEngine();
     Amount_t minSumTrade;
+    unique_ptr<ThreadPool> threadPool;
+    unique_ptr<AbstractTradeEngine> tradeEngine;
+    //trades of the current block, which may be stepped through pair by pair
+    RoundInfo blockInfo;
+    RoundProfile roundProfile, lastRoundProfile, totalProfile;
+    StoppingCriteria stoppingCriteria;
+    unique_ptr<AbstractStoppingRule> stoppingRule;
+    HistogramSettings histogramSettings;
+
+    friend struct CheckpointIo;
 };
 
 struct EdgeworthSituation {
-    Simulation::ActorConstRef actor1, actor2;
+    Simulation::ActorValues actor1, actor2;
     IndifferenceCurve const curve1, curve2;
     Amount_t const q1Sum, q2Sum;
+    //both intersections and the utilities after the offer are computed once, with the situation
+    Position const curve1ParetoIntersection, curve2ParetoIntersection;
     Position const result;
+    Amount_t const newUtility1, newUtility2;
+    //what the acceptance strategy decided, successful also requires the minimum sum of trade
+    bool const accepted;
     bool const successful;
 
+    //Through the abstract strategies the calls are virtual, through the final ones they inline
+    template<typename OfferStrategy, typename AcceptanceStrategy>
     EdgeworthSituation(Simulation const& simulation, size_t const actor1Idx, size_t const actor2Idx,
-                       AbstractOfferStrategy& offerStrategy, AbstractAcceptanceStrategy &acceptanceStrategy, URNG &rng);
+                       OfferStrategy const& offerStrategy, AcceptanceStrategy const& acceptanceStrategy, URNG &rng);
 
     bool isItSuccessful(bool consideration, Amount_t minimum) const;
     CurveFunction getCurve1Function() const;
@@ -178,10 +345,29 @@ struct EdgeworthSituation {
     Position calculateCurve1ParetoIntersection() const;
     Position calculateCurve2ParetoIntersection() const;
     Position calculateActor2Result() const;
-    Amount_t calculateOriginalUtility(Simulation::ActorConstRef const& actor) const;
+    Amount_t calculateOriginalUtility(Simulation::ActorValues const& actor) const;
     Amount_t calculateNewUtilityActor1() const;
     Amount_t calculateNewUtilityActor2() const;
 
 private:
-    Amount_t calculateParetoIntersectionQ1(IndifferenceCurve const& curve) const;
+    Position calculateParetoIntersectionOfActor2() const;
 };
+
+template<typename OfferStrategy, typename AcceptanceStrategy>
+EdgeworthSituation::EdgeworthSituation(const Simulation& simulation, const size_t actor1Idx, const size_t actor2Idx,
+        OfferStrategy const& offerStrategy, AcceptanceStrategy const& acceptanceStrategy, URNG& rng)
+    : actor1(simulation, actor1Idx)
+    , actor2(simulation, actor2Idx)
+    , curve1(simulation.utility, actor1.q1, actor1.q2)
+    , curve2(simulation.utility, actor2.q1, actor2.q2)
+    , q1Sum(actor1.q1 + actor2.q1)
+    , q2Sum(actor1.q2 + actor2.q2)
+    , curve1ParetoIntersection(simulation.utility.computeParetoIntersection(actor1.q1, actor1.q2, q1Sum, q2Sum))
+    , curve2ParetoIntersection(calculateParetoIntersectionOfActor2())
+    , result(offerStrategy.propose(*this, rng))
+    , newUtility1(simulation.utility.compute(result.q1, result.q2))
+    , newUtility2(simulation.utility.compute(q1Sum - result.q1, q2Sum - result.q2))
+    , accepted(acceptanceStrategy.consider(*this))
+    , successful(isItSuccessful(accepted, simulation.getMinSumTrade()))
+{
+}
@@ -0,0 +1,46 @@
+# Simulation model shared by the MarketPlayer targets
+
+# Vectorized actor kernels, e.g. qmake CONFIG+=simd_avx2
+simd_avx512 {
+    msvc: QMAKE_CXXFLAGS += /arch:AVX512
+    else: QMAKE_CXXFLAGS += -mavx512f -ffp-contract=off
+} else: simd_avx2 {
+    msvc: QMAKE_CXXFLAGS += /arch:AVX2
+    else: QMAKE_CXXFLAGS += -mavx2 -ffp-contract=off
+}
+
+CONFIG += thread
+
+# Lets the geometry of EdgeworthSituation inline into the trade engine
+CONFIG(release, debug|release): CONFIG += ltcg
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/model.cpp \
+    $$PWD/modelutils.cpp \
+    $$PWD/strategy.cpp \
+    $$PWD/actorstore.cpp \
+    $$PWD/actorkernels.cpp \
+    $$PWD/threadpool.cpp \
+    $$PWD/workstealingscheduler.cpp \
+    $$PWD/ensemble.cpp \
+    $$PWD/roundprofile.cpp \
+    $$PWD/stoppingrule.cpp \
+    $$PWD/philox.cpp
+
+HEADERS += \
+    $$PWD/model.h \
+    $$PWD/modelutils.h \
+    $$PWD/strategy.h \
+    $$PWD/actorstore.h \
+    $$PWD/actorkernels.h \
+    $$PWD/threadpool.h \
+    $$PWD/workstealingscheduler.h \
+    $$PWD/ensemble.h \
+    $$PWD/roundprofile.h \
+    $$PWD/stoppingrule.h \
+    $$PWD/philox.h \
+    $$PWD/tradeengine.h \
+    $$PWD/goods.h \
+    $$PWD/goodseconomy.h
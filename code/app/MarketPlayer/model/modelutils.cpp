@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <numeric>
+#include <limits>
+
 #include "modelutils.h"
 
 bool ResourceToleranceEquality::operator()(const Amount_t& x, const Amount_t& y) const {
@@ -12,37 +16,303 @@ ResourceDataPair sampleFunction(std::function<double (double)> func, Amount_t ra
     return dataPair;
 }
 
-Distribution::Distribution(const vector<Amount_t>& subject, Amount_t resolution)
+HistogramLayout::HistogramLayout()
+    : scale(LinearScale)
+    , resolution(1.0)
+    , firstEdge(0.0)
+    , lastEdge(0.0)
+    , maxBuckets(std::numeric_limits<size_t>::max())
+    , ratio(1.0)
+    , logRatio(0.0)
+{}
+
+HistogramLayout HistogramLayout::linear(Amount_t resolution, size_t maxBuckets)
+{
+    HistogramLayout layout;
+    layout.resolution = resolution;
+    layout.maxBuckets = std::max<size_t>(maxBuckets, 1);
+    return layout;
+}
+
+HistogramLayout HistogramLayout::logarithmic(Amount_t firstEdge, Amount_t lastEdge, size_t maxBuckets)
+{
+    HistogramLayout layout;
+    layout.scale = LogScale;
+    layout.maxBuckets = std::max<size_t>(maxBuckets, 1);
+    layout.firstEdge = firstEdge;
+    layout.lastEdge = lastEdge;
+    layout.ratio = pow(lastEdge / firstEdge, 1.0 / layout.maxBuckets);
+    layout.logRatio = log(layout.ratio);
+    return layout;
+}
+
+size_t HistogramLayout::getBucketIdx(Amount_t value) const
+{
+    Amount_t bucketIdx = 0.0;
+    if (scale == LogScale) {
+        bucketIdx = value > firstEdge ? floor(log(value / firstEdge) / logRatio) : 0.0;
+    } else {
+        bucketIdx = floor(value / resolution);
+    }
+    //compared as floating point, a far outlier does not fit into size_t
+    return bucketIdx < static_cast<Amount_t>(maxBuckets - 1) ? static_cast<size_t>(bucketIdx) : maxBuckets - 1;
+}
+
+Amount_t HistogramLayout::getLowerEdge(size_t bucketIdx) const
+{
+    return scale == LogScale ? firstEdge * pow(ratio, bucketIdx) : resolution * bucketIdx;
+}
+
+Amount_t HistogramLayout::getUpperEdge(size_t bucketIdx) const
+{
+    return getLowerEdge(bucketIdx + 1);
+}
+
+Amount_t HistogramLayout::getCenter(size_t bucketIdx) const
+{
+    return scale == LogScale ? firstEdge * pow(ratio, bucketIdx + 0.5) : resolution * bucketIdx + resolution/2;
+}
+
+bool HistogramLayout::operator==(const HistogramLayout &other) const
+{
+    return scale == other.scale && resolution == other.resolution && firstEdge == other.firstEdge
+            && lastEdge == other.lastEdge && maxBuckets == other.maxBuckets;
+}
+
+HistogramSettings::HistogramSettings()
+    : scale(HistogramLayout::LinearScale)
+    , maxBuckets(defaultMaxBuckets)
+{}
+
+InequalityMetrics::InequalityMetrics()
+    : gini(0.0)
+    , p10(0.0)
+    , p50(0.0)
+    , p90(0.0)
+    , p99(0.0)
+    , topShare(0.0)
+{}
+
+namespace {
+
+//Where the values of a bucket are spread: between its edges, the open ends reaching
+//as far as needed for the mean of the bucket to lie in the middle
+void getBucketRange(HistogramLayout const& layout, size_t bucketIdx, Amount_t mean, Amount_t& lower, Amount_t& upper)
+{
+    lower = layout.getLowerEdge(bucketIdx);
+    upper = layout.getUpperEdge(bucketIdx);
+    if (layout.scale == HistogramLayout::LogScale && bucketIdx == 0) {
+        lower = std::max(0.0, std::min(lower, 2*mean - upper));
+    }
+    if (bucketIdx == layout.maxBuckets - 1) {
+        upper = std::max(upper, 2*mean - lower);
+    }
+}
+
+}
+
+InequalityMetrics calculateInequality(const HistogramLayout &layout, const vector<Amount_t> &counts, const vector<Amount_t> &sums)
+{
+    InequalityMetrics metrics;
+    size_t const numBuckets = std::min(counts.size(), sums.size());
+    Amount_t numValues = 0.0, total = 0.0;
+    for (size_t idx = 0; idx < numBuckets; ++idx) {
+        numValues += counts[idx];
+        total += sums[idx];
+    }
+    if (numValues <= 0.0 || total <= 0.0) {
+        return metrics;
+    }
+
+    //a single ascending pass: the quantiles by their ranks, the Gini coefficient
+    //from the Lorenz curve of the buckets, G = 1 - sum of p_i * (L_i-1 + L_i),
+    //plus the spread within the buckets, sum of p_i * s_i * G_i (p_i of the values, s_i of the total).
+    //Taking the values of a bucket as uniform between its edges, G_i is (1 - 1/count) * width / (6 * mean).
+    //The rest of the error is the shape within the buckets, at most the within term itself:
+    //for buckets of width w below w / (6 * mean of all values) times the largest p_i.
+    Amount_t* const quantiles[] = {&metrics.p10, &metrics.p50, &metrics.p90, &metrics.p99};
+    Amount_t const quantileFractions[] = {0.10, 0.50, 0.90, 0.99};
+    size_t const numQuantiles = sizeof(quantiles) / sizeof(quantiles[0]);
+    size_t quantileIdx = 0;
+    Amount_t belowCount = 0.0, belowSum = 0.0, lorenzArea = 0.0, withinGini = 0.0;
+    for (size_t idx = 0; idx < numBuckets; ++idx) {
+        Amount_t const count = counts[idx];
+        if (count <= 0.0) {
+            continue;
+        }
+        Amount_t lower, upper;
+        getBucketRange(layout, idx, sums[idx] / count, lower, upper);
+        while (quantileIdx < numQuantiles && belowCount + count >= quantileFractions[quantileIdx] * numValues) {
+            Amount_t const rank = quantileFractions[quantileIdx] * numValues - belowCount;
+            *quantiles[quantileIdx] = lower + (upper - lower) * rank / count;
+            ++quantileIdx;
+        }
+        Amount_t const lorenzBefore = belowSum / total;
+        belowCount += count;
+        belowSum += sums[idx];
+        lorenzArea += count / numValues * (lorenzBefore + belowSum / total);
+        withinGini += count * std::max(0.0, count - 1.0) * (upper - lower) / (6.0 * numValues * total);
+    }
+    metrics.gini = std::min(1.0, std::max(0.0, 1.0 - lorenzArea + withinGini));
+
+    //a descending pass until the top fraction of the values is taken,
+    //of the last bucket its upper part, whose mean is above the bucket's mean
+    Amount_t remaining = InequalityMetrics::topShareFraction * numValues;
+    Amount_t topSum = 0.0;
+    for (size_t idx = numBuckets; idx > 0 && remaining > 0.0; --idx) {
+        Amount_t const count = counts[idx-1];
+        if (count <= 0.0) {
+            continue;
+        }
+        if (count <= remaining) {
+            topSum += sums[idx-1];
+            remaining -= count;
+        } else {
+            Amount_t const mean = sums[idx-1] / count;
+            Amount_t lower, upper;
+            getBucketRange(layout, idx-1, mean, lower, upper);
+            Amount_t const partMean = mean + (1.0 - remaining / count) * (upper - lower) / 2;
+            topSum += std::min(remaining * partMean, sums[idx-1]);
+            remaining = 0.0;
+        }
+    }
+    metrics.topShare = topSum / total;
+    return metrics;
+}
+
+Distribution::Distribution(ConstAmountSpan subject, HistogramLayout const& layout)
     : subject(subject)
-    , resolution(resolution)
+    , layout(layout)
     , maxSubject(*std::max_element(subject.begin(), subject.end()))
-    , numBuckets(static_cast<size_t>(ceil(maxSubject/resolution)))
+    , numBuckets(layout.getBucketIdx(maxSubject) + 1)
 {
     data.resize(numBuckets);
 
-    //optimization possibility:
-    Amount_t currentBucket = resolution/2;
-    for (size_t idx = 0; idx < numBuckets; ++idx, currentBucket += resolution) {
-        data.x[idx] = currentBucket;
+    for (size_t idx = 0; idx < numBuckets; ++idx) {
+        data.x[idx] = layout.getCenter(idx);
     }
 
     for (auto const& amount : subject) {
-        auto bucketIdx = static_cast<ResourceDataPair::size_type>(floor(amount/resolution));
-        data.y[bucketIdx] += 1;
+        data.y[layout.getBucketIdx(amount)] += 1;
     }
 }
 
-void HeavyDistribution::setup(const vector<Amount_t> &subject, Amount_t resolution)
+void HeavyDistribution::setup(ConstAmountSpan subject, HistogramLayout const& layout)
 {
-    Distribution distribution(subject, resolution);
+    Distribution distribution(subject, layout);
     this->data = std::move(distribution.data);
-    this->resolution = distribution.resolution;
+    this->layout = distribution.layout;
     this->maxSubject = distribution.maxSubject;
     this->maxNum = *std::max_element(data.y.begin(), data.y.end());
     this->numBuckets = distribution.numBuckets;
     this->standardDeviation = calculateStandardDeviation(subject);
 }
 
+//maxSubject is the upper edge of the highest used bucket, the exact maximum is not tracked
+void HeavyDistribution::setup(const RunningDistribution &running)
+{
+    numBuckets = running.getNumUsedBuckets();
+    layout = running.getLayout();
+    maxSubject = numBuckets > 0 ? layout.getUpperEdge(numBuckets - 1) : 0.0;
+    data.x = running.getBucketCenters();
+    data.y = running.getBucketCounts();
+    data.resize(numBuckets);
+    maxNum = numBuckets > 0 ? *std::max_element(data.y.begin(), data.y.end()) : 0.0;
+    standardDeviation = running.calculateStandardDeviation();
+}
+
+RunningDistribution::RunningDistribution()
+    : count(0)
+    , shift(0.0)
+    , shiftedSum(0.0)
+    , shiftedSquareSum(0.0)
+{}
+
+void RunningDistribution::setup(ConstAmountSpan subject, HistogramLayout const& layout)
+{
+    reset(layout, subject.size() > 0 ?
+              std::accumulate(subject.begin(), subject.end(), 0.0) / subject.size() : 0.0);
+    for (auto const& value : subject) {
+        add(value);
+    }
+}
+
+void RunningDistribution::reset(HistogramLayout const& layout, Amount_t shift)
+{
+    if (layout == this->layout) {
+        counts.fill(0.0);
+        sums.fill(0.0);
+    } else {
+        this->layout = layout;
+        centers.resize(0);
+        counts.resize(0);
+        sums.resize(0);
+    }
+    count = 0;
+    this->shift = shift;
+    shiftedSum = 0.0;
+    shiftedSquareSum = 0.0;
+}
+
+void RunningDistribution::add(Amount_t value)
+{
+    size_t const bucketIdx = layout.getBucketIdx(value);
+    if (bucketIdx >= static_cast<size_t>(counts.size())) {
+        for (size_t idx = counts.size(); idx <= bucketIdx; ++idx) {
+            centers.push_back(layout.getCenter(idx));
+            counts.push_back(0.0);
+            sums.push_back(0.0);
+        }
+    }
+    counts[bucketIdx] += 1;
+    sums[bucketIdx] += value;
+    ++count;
+    Amount_t const shifted = value - shift;
+    shiftedSum += shifted;
+    shiftedSquareSum += shifted * shifted;
+}
+
+//The value must have been added before
+void RunningDistribution::remove(Amount_t value)
+{
+    size_t const bucketIdx = layout.getBucketIdx(value);
+    counts[bucketIdx] -= 1;
+    sums[bucketIdx] -= value;
+    --count;
+    Amount_t const shifted = value - shift;
+    shiftedSum -= shifted;
+    shiftedSquareSum -= shifted * shifted;
+}
+
+size_t RunningDistribution::getNumUsedBuckets() const
+{
+    size_t numUsed = counts.size();
+    while (numUsed > 0 && counts[numUsed-1] == 0) {
+        --numUsed;
+    }
+    return numUsed;
+}
+
+Amount_t RunningDistribution::getSum() const
+{
+    return shift * count + shiftedSum;
+}
+
+Amount_t RunningDistribution::calculateStandardDeviation() const
+{
+    if (count > 1) {
+        Amount_t const squaredDeviations = shiftedSquareSum - shiftedSum * shiftedSum / count;
+        return sqrt(std::max(0.0, squaredDeviations) / (count-1));
+    } else {
+        return 0.0;
+    }
+}
+
+InequalityMetrics RunningDistribution::calculateInequality() const
+{
+    return ::calculateInequality(layout, counts, sums);
+}
+
 bool isPointInTriangle(const Position& p0, const Position& p1, const Position& p2, const Position& px) {
     //Barycentric method
 
@@ -2,8 +2,16 @@
 #define MODELUTILS_H
 
 #include <functional>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+#include <memory>
+#include <vector>
 #include <QVector>
 
+#include "philox.h"
+
 #define CLONEABLE(Type) virtual Type* clone() const override { return new Type(*this); }
 
 #define VISITABLE_BY(VisitorClass) virtual void accept (VisitorClass& v) override { v.visit(*this); }
@@ -19,7 +27,7 @@ using vector = QVector<E>;
 struct Position;
 extern std::function<void(Position const&)> debugShowPoint;
 
-typedef std::mt19937 URNG;
+typedef Philox4x32 URNG;
 extern URNG globalUrng;
 
 struct Position
@@ -36,6 +44,18 @@ struct Position
     }
 };
 
+//Whether owner holds the only reference, so it may write through it. use_count loads relaxed,
+//the fence orders the writes after the reads of the threads that dropped their references.
+template<typename T>
+bool isSoleOwner(std::shared_ptr<T> const& owner)
+{
+    if (owner.use_count() != 1) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
 template<typename T>
 struct DataPair
 {
@@ -60,32 +80,173 @@ struct DataPair
 
 typedef DataPair<Amount_t> ResourceDataPair;
 
+//Sequence stored in fixed-size chunks that copies share: a copy costs O(chunks),
+//and the elements already written stay shared until one side changes them.
+//Appending copies at most the last chunk, if it is shared.
+template<typename T, size_t ChunkSize = 256>
+struct ChunkedSeries
+{
+    ChunkedSeries(): count(0) {}
+
+    size_t size() const { return count; }
+    T const& operator[](size_t idx) const {
+        return (*chunks[idx / ChunkSize])[idx % ChunkSize];
+    }
+    T const& back() const { return (*this)[count - 1]; }
+    T& back() {
+        return provideOwnChunk(chunks.size() - 1).back();
+    }
+    void push_back(T const& element) {
+        if (count % ChunkSize == 0) {
+            chunks.push_back(std::make_shared<Chunk>());
+            chunks.back()->reserve(ChunkSize);
+        }
+        provideOwnChunk(chunks.size() - 1).push_back(element);
+        ++count;
+    }
+    void clear() {
+        chunks.clear();
+        count = 0;
+    }
+    //Keeps the elements whose index satisfies keep, in order.
+    //Chunks before the first dropped element stay shared.
+    template<typename Keep>
+    void retainIf(Keep keep) {
+        size_t firstDropped = 0;
+        while (firstDropped < count && keep(firstDropped)) {
+            ++firstDropped;
+        }
+        if (firstDropped == count) {
+            return;
+        }
+        std::vector<T> moved;
+        for (size_t idx = firstDropped + 1; idx < count; ++idx) {
+            if (keep(idx)) {
+                moved.push_back((*this)[idx]);
+            }
+        }
+        chunks.resize((firstDropped + ChunkSize - 1) / ChunkSize);
+        if (firstDropped % ChunkSize != 0) {
+            provideOwnChunk(chunks.size() - 1).resize(firstDropped % ChunkSize);
+        }
+        count = firstDropped;
+        for (auto const& element : moved) {
+            push_back(element);
+        }
+    }
+
+private:
+    typedef std::vector<T> Chunk;
+
+    Chunk& provideOwnChunk(size_t chunkIdx) {
+        auto& chunk = chunks[chunkIdx];
+        if (!isSoleOwner(chunk)) {
+            auto own = std::make_shared<Chunk>();
+            own->reserve(ChunkSize);
+            own->assign(chunk->begin(), chunk->end());
+            chunk = own;
+        }
+        return *chunk;
+    }
+
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    size_t count;
+};
+
+//x is the time, which is not the index once the series has been thinned.
+//Copies share the points pushed so far.
 struct DataTimePair
 {
-    DataPair<Amount_t> data;
+    ChunkedSeries<Amount_t, 4096> x, y;
     Amount_t max;
 
-    DataPair<Amount_t>::size_type size() const {
-        return data.size();
+    size_t size() const {
+        return y.size();
     }
     Amount_t getLastX() const {
-        return data.x.size() - 1;
+        return x.size() > 0 ? x.back() : -1;
     }
     void push(Amount_t newData) {
-        data.push(getLastX() + 1, newData);
+        push(getLastX() + 1, newData);
+    }
+    void push(Amount_t time, Amount_t newData) {
+        x.push_back(time);
+        y.push_back(newData);
         if (newData > max) {
             max = newData;
         }
     }
     void reset() {
         max = 0.0;
-        data.reset();
+        x.clear();
+        y.clear();
     }
     Amount_t const& operator[](size_t idx) const {
-        return data.y[idx];
+        return y[idx];
+    }
+    Amount_t getX(size_t idx) const {
+        return x[idx];
+    }
+    //Index of the point nearest to time, preferring the earlier one on ties
+    size_t findNearestIdx(Amount_t time) const {
+        size_t after = 0;
+        size_t count = size();
+        while (count > 0) {
+            size_t const step = count / 2;
+            if (x[after + step] < time) {
+                after += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        if (after == 0) {
+            return 0;
+        }
+        if (after == size() || time - x[after - 1] <= x[after] - time) {
+            return after - 1;
+        }
+        return after;
+    }
+    template<typename Keep>
+    void retainIf(Keep keep) {
+        x.retainIf(keep);
+        y.retainIf(keep);
+    }
+    ResourceDataPair toDataPair() const {
+        ResourceDataPair result;
+        result.resize(size());
+        for (size_t idx = 0; idx < size(); ++idx) {
+            result.x[idx] = x[idx];
+            result.y[idx] = y[idx];
+        }
+        return result;
     }
 };
 
+//Non-owning view of contiguous amounts, e.g. one column of the actor store.
+struct ConstAmountSpan
+{
+    typedef Amount_t value_type;
+    typedef Amount_t const* const_iterator;
+
+    Amount_t const* first;
+    size_t count;
+
+    ConstAmountSpan(Amount_t const* first, size_t count)
+        : first(first)
+        , count(count)
+    {}
+    ConstAmountSpan(vector<Amount_t> const& subject)
+        : first(subject.constData())
+        , count(subject.size())
+    {}
+
+    const_iterator begin() const { return first; }
+    const_iterator end() const { return first + count; }
+    size_t size() const { return count; }
+};
+
 struct IndexNumber
 {
     unsigned int actual;
@@ -100,9 +261,10 @@ struct ResourceToleranceEquality
     bool operator()(Amount_t const& x, Amount_t const& y) const;
 };
 
-template<typename T>
-T calculateStandardDeviation(vector<T> const& subject)
+template<typename Container>
+typename Container::value_type calculateStandardDeviation(Container const& subject)
 {
+    typedef typename Container::value_type T;
     if (subject.size() > 1) {
         auto const sum = std::accumulate(subject.begin(), subject.end(), 0.0);
         auto const mean = sum / subject.size();
@@ -119,27 +281,168 @@ T calculateStandardDeviation(vector<T> const& subject)
 
 ResourceDataPair sampleFunction(std::function<double(double)> func, Amount_t rangeStart, Amount_t rangeFinish, Amount_t resolution);
 
+template<typename Func>
+void refineSample(Func const& func, Amount_t x0, Amount_t y0, Amount_t x1, Amount_t y1,
+                  Amount_t xScale, Amount_t yScale, Amount_t tolerance, int depth, ResourceDataPair& result)
+{
+    Amount_t const xMid = (x0 + x1) / 2;
+    Amount_t const yMid = func(xMid);
+    //distance of the midpoint from the chord, measured in the scales
+    Amount_t const dx = (x1 - x0) / xScale;
+    Amount_t const dy = (y1 - y0) / yScale;
+    Amount_t const distance = std::abs(yMid - (y0 + y1) / 2) / yScale * dx / std::sqrt(dx*dx + dy*dy);
+    if (depth > 0 && !(distance <= tolerance)) {
+        refineSample(func, x0, y0, xMid, yMid, xScale, yScale, tolerance, depth - 1, result);
+        refineSample(func, xMid, yMid, x1, y1, xScale, yScale, tolerance, depth - 1, result);
+    } else {
+        result.push(x1, y1);
+    }
+}
+
+//Samples func on [rangeStart, rangeFinish] densely where it bends and sparsely where it is straight:
+//a segment is halved while its midpoint is farther than tolerance from the chord, distances taken
+//in units of xScale and yScale (e.g. the plotted ranges). Overwrites result, keeping its capacity.
+template<typename Func>
+void sampleFunctionAdaptive(Func const& func, Amount_t rangeStart, Amount_t rangeFinish,
+                            Amount_t xScale, Amount_t yScale, Amount_t tolerance, ResourceDataPair& result)
+{
+    //a few even segments first, so a bend is not missed between two distant samples
+    int const numSegments = 16;
+    int const maxDepth = 16;
+    result.reset();
+    Amount_t x0 = rangeStart;
+    Amount_t y0 = func(x0);
+    result.push(x0, y0);
+    for (int segmentIdx = 1; segmentIdx <= numSegments; ++segmentIdx) {
+        Amount_t const x1 = rangeStart + (rangeFinish - rangeStart) * segmentIdx / numSegments;
+        Amount_t const y1 = func(x1);
+        refineSample(func, x0, y0, x1, y1, xScale, yScale, tolerance, maxDepth, result);
+        x0 = x1;
+        y0 = y1;
+    }
+}
+
+//How a histogram maps values to its buckets, there are at most maxBuckets of them whatever the values.
+//Linear buckets are resolution wide, the last one takes the values beyond it too.
+//Log buckets grow by ratio from firstEdge on, the first one takes the values below it too.
+struct HistogramLayout
+{
+    enum Scale {
+        LinearScale,
+        LogScale
+    };
+
+    HistogramLayout();
+    static HistogramLayout linear(Amount_t resolution, size_t maxBuckets);
+    //maxBuckets buckets between firstEdge and lastEdge
+    static HistogramLayout logarithmic(Amount_t firstEdge, Amount_t lastEdge, size_t maxBuckets);
+
+    size_t getBucketIdx(Amount_t value) const;
+    Amount_t getLowerEdge(size_t bucketIdx) const;
+    Amount_t getUpperEdge(size_t bucketIdx) const;
+    //the geometric center for log buckets
+    Amount_t getCenter(size_t bucketIdx) const;
+    bool operator==(HistogramLayout const& other) const;
+
+    //read only, set them through the factories
+    Scale scale;
+    Amount_t resolution;
+    Amount_t firstEdge, lastEdge;
+    size_t maxBuckets;
+    //derived from the edges
+    Amount_t ratio;
+
+private:
+    Amount_t logRatio;
+};
+
+//What the simulation builds its histogram layouts from
+struct HistogramSettings
+{
+    HistogramSettings();
+
+    HistogramLayout::Scale scale;
+    size_t maxBuckets;
+
+    static const size_t defaultMaxBuckets = 1024;
+};
+
 struct Distribution {
-    vector<Amount_t> const& subject;
-    Amount_t const resolution;
+    ConstAmountSpan const subject;
+    HistogramLayout const layout;
     Amount_t const maxSubject;
     size_t const numBuckets;
 
     ResourceDataPair data;
 
-    Distribution(vector<Amount_t> const& subject, Amount_t resolution);
+    Distribution(ConstAmountSpan subject, HistogramLayout const& layout);
+};
+
+//Inequality of a distribution, estimated from its histogram
+struct InequalityMetrics
+{
+    InequalityMetrics();
+
+    Amount_t gini;
+    Amount_t p10, p50, p90, p99;
+    //share of the sum held by the top topShareFraction of the values
+    Amount_t topShare;
+
+    static constexpr Amount_t topShareFraction = 0.01;
+};
+
+//Values are taken as spread evenly over their bucket, the open first and last buckets
+//as far as the mean of their values requires. Costs O(buckets), the error is bounded by the bucket widths
+//(relative for log buckets). sums[idx] is the sum of the values counted in bucket idx.
+InequalityMetrics calculateInequality(HistogramLayout const& layout, vector<Amount_t> const& counts, vector<Amount_t> const& sums);
+
+//Histogram and moments kept up to date value by value: replacing a value costs O(1),
+//a snapshot costs O(buckets) instead of O(subject).
+//The moments are summed around the mean at setup to keep the cancellation small.
+//It is a sketch of the values which, unlike t-digest or KLL, takes removals too;
+//two of the same layout merge by adding their buckets.
+struct RunningDistribution
+{
+    RunningDistribution();
+    void setup(ConstAmountSpan subject, HistogramLayout const& layout);
+    //Empties it for values to be added one by one. The moments are summed around shift,
+    //which only has to be near the mean. The buckets are kept if the layout stays.
+    void reset(HistogramLayout const& layout, Amount_t shift);
+    void add(Amount_t value);
+    void remove(Amount_t value);
+
+    HistogramLayout const& getLayout() const { return layout; }
+    size_t getNumUsedBuckets() const;
+    vector<Amount_t> const& getBucketCenters() const { return centers; }
+    vector<Amount_t> const& getBucketCounts() const { return counts; }
+    vector<Amount_t> const& getBucketSums() const { return sums; }
+    Amount_t getSum() const;
+    Amount_t calculateStandardDeviation() const;
+    InequalityMetrics calculateInequality() const;
+
+private:
+    HistogramLayout layout;
+    vector<Amount_t> centers;
+    vector<Amount_t> counts;
+    vector<Amount_t> sums;
+    size_t count;
+    Amount_t shift;
+    Amount_t shiftedSum, shiftedSquareSum;
+
+    friend struct CheckpointIo;
 };
 
 struct HeavyDistribution
 {
-    Amount_t resolution;
+    HistogramLayout layout;
     Amount_t maxSubject;
     Amount_t maxNum;
     size_t numBuckets;
     ResourceDataPair data;
     Amount_t standardDeviation;
 
-    void setup(vector<Amount_t> const& subject, Amount_t resolution);
+    void setup(ConstAmountSpan subject, HistogramLayout const& layout);
+    void setup(RunningDistribution const& running);
 };
 
 bool isPointInTriangle(Position const& p0, Position const& p1, Position const& p2, Position const& px);
@@ -0,0 +1,130 @@
+#include "philox.h"
+
+namespace {
+
+uint32_t const multiplier0 = 0xD2511F53u;
+uint32_t const multiplier1 = 0xCD9E8D57u;
+uint32_t const weyl0 = 0x9E3779B9u;
+uint32_t const weyl1 = 0xBB67AE85u;
+int const numRounds = 10;
+unsigned const blockSize = 4;
+
+inline void multiplyHighLow(uint32_t a, uint32_t b, uint32_t& high, uint32_t& low)
+{
+    uint64_t const product = static_cast<uint64_t>(a) * b;
+    high = static_cast<uint32_t>(product >> 32);
+    low = static_cast<uint32_t>(product);
+}
+
+}
+
+Philox4x32::Philox4x32()
+{
+    seed(0);
+}
+
+Philox4x32::Philox4x32(result_type seed)
+{
+    this->seed(seed);
+}
+
+Philox4x32::Philox4x32(uint64_t key, uint32_t streamHigh, uint32_t streamLow)
+{
+    this->key[0] = static_cast<uint32_t>(key);
+    this->key[1] = static_cast<uint32_t>(key >> 32);
+    counter[0] = 0;
+    counter[1] = 0;
+    counter[2] = streamLow;
+    counter[3] = streamHigh;
+    blockIdx = blockSize;
+}
+
+void Philox4x32::seed(result_type seed)
+{
+    key[0] = seed;
+    key[1] = 0;
+    for (auto& word : counter) {
+        word = 0;
+    }
+    blockIdx = blockSize;
+}
+
+Philox4x32::result_type Philox4x32::operator()()
+{
+    if (blockIdx == blockSize) {
+        generateBlock();
+        if (++counter[0] == 0) {
+            ++counter[1];
+        }
+        blockIdx = 0;
+    }
+    return block[blockIdx++];
+}
+
+void Philox4x32::discard(unsigned long long numDraws)
+{
+    setPosition(getPosition() + numDraws);
+}
+
+uint64_t Philox4x32::getKey() const
+{
+    return (static_cast<uint64_t>(key[1]) << 32) | key[0];
+}
+
+//Number of values drawn from the stream so far
+uint64_t Philox4x32::getPosition() const
+{
+    uint64_t const nextBlock = (static_cast<uint64_t>(counter[1]) << 32) | counter[0];
+    return nextBlock * blockSize - (blockSize - blockIdx);
+}
+
+void Philox4x32::setPosition(uint64_t position)
+{
+    uint64_t const blockNumber = position / blockSize;
+    unsigned const offset = static_cast<unsigned>(position % blockSize);
+    counter[0] = static_cast<uint32_t>(blockNumber);
+    counter[1] = static_cast<uint32_t>(blockNumber >> 32);
+    blockIdx = blockSize;
+    if (offset != 0) {
+        generateBlock();
+        if (++counter[0] == 0) {
+            ++counter[1];
+        }
+        blockIdx = offset;
+    }
+}
+
+bool Philox4x32::operator==(const Philox4x32 &other) const
+{
+    return getKey() == other.getKey()
+            && counter[2] == other.counter[2] && counter[3] == other.counter[3]
+            && getPosition() == other.getPosition();
+}
+
+void Philox4x32::generateBlock()
+{
+    computeBlock(counter, key, block);
+}
+
+void Philox4x32::computeBlock(uint32_t const counter[4], uint32_t const key[2], uint32_t block[4])
+{
+    uint32_t x0 = counter[0], x1 = counter[1], x2 = counter[2], x3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < numRounds; ++round) {
+        uint32_t high0, low0, high1, low1;
+        multiplyHighLow(multiplier0, x0, high0, low0);
+        multiplyHighLow(multiplier1, x2, high1, low1);
+        uint32_t const y0 = high1 ^ x1 ^ k0;
+        uint32_t const y2 = high0 ^ x3 ^ k1;
+        x0 = y0;
+        x1 = low1;
+        x2 = y2;
+        x3 = low0;
+        k0 += weyl0;
+        k1 += weyl1;
+    }
+    block[0] = x0;
+    block[1] = x1;
+    block[2] = x2;
+    block[3] = x3;
+}
@@ -0,0 +1,44 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cstdint>
+
+//Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+//Every block of four outputs is a pure function of (key, counter), so any position of any stream
+//can be computed directly, and copying a generator copies a few words only.
+//The 128-bit counter is split into a 64-bit draw index and two 32-bit stream coordinates.
+struct Philox4x32
+{
+    typedef uint32_t result_type;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xFFFFFFFFu; }
+
+    Philox4x32();
+    explicit Philox4x32(result_type seed);
+    Philox4x32(uint64_t key, uint32_t streamHigh, uint32_t streamLow);
+
+    void seed(result_type seed);
+    result_type operator()();
+    void discard(unsigned long long numDraws);
+
+    uint64_t getKey() const;
+    uint64_t getPosition() const;
+    void setPosition(uint64_t position);
+
+    bool operator==(Philox4x32 const& other) const;
+    bool operator!=(Philox4x32 const& other) const { return !(*this == other); }
+
+    //The Philox4x32-10 bijection itself: the four outputs of counter under key
+    static void computeBlock(uint32_t const counter[4], uint32_t const key[2], uint32_t block[4]);
+
+private:
+    void generateBlock();
+
+    uint32_t key[2];
+    uint32_t counter[4];
+    uint32_t block[4];
+    unsigned blockIdx;
+};
+
+#endif // PHILOX_H
@@ -0,0 +1,50 @@
+#include "roundprofile.h"
+
+RoundProfile::RoundProfile()
+{
+    reset();
+}
+
+void RoundProfile::reset()
+{
+    numRounds = 0;
+    numPairs = 0;
+    numAccepted = 0;
+    numRejectedByConsider = 0;
+    numRejectedByMinimum = 0;
+    numSampledPairs = 0;
+    phaseNanoseconds.fill(0);
+    wallNanoseconds = 0;
+}
+
+void RoundProfile::merge(const RoundProfile &other)
+{
+    numRounds += other.numRounds;
+    numPairs += other.numPairs;
+    numAccepted += other.numAccepted;
+    numRejectedByConsider += other.numRejectedByConsider;
+    numRejectedByMinimum += other.numRejectedByMinimum;
+    numSampledPairs += other.numSampledPairs;
+    for (size_t phase = 0; phase < NumPhases; ++phase) {
+        phaseNanoseconds[phase] += other.phaseNanoseconds[phase];
+    }
+    wallNanoseconds += other.wallNanoseconds;
+}
+
+void RoundProfile::addSample(int64_t situationNs, int64_t proposeNs, int64_t considerNs, int64_t tradeNs)
+{
+    ++numSampledPairs;
+    phaseNanoseconds[SituationPhase] += situationNs;
+    phaseNanoseconds[ProposePhase] += proposeNs;
+    phaseNanoseconds[ConsiderPhase] += considerNs;
+    phaseNanoseconds[TradePhase] += tradeNs;
+}
+
+double RoundProfile::getEstimatedSeconds(Phase phase) const
+{
+    double const seconds = phaseNanoseconds[phase] * 1e-9;
+    if (!isPerPairPhase(phase)) {
+        return seconds;
+    }
+    return numSampledPairs > 0 ? seconds * numPairs / numSampledPairs : 0.0;
+}
@@ -0,0 +1,64 @@
+#ifndef ROUNDPROFILE_H
+#define ROUNDPROFILE_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+//Monotonic nanoseconds, only their differences are meaningful
+inline int64_t profileClockNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//Where the time of the rounds went and how their pairs ended.
+//Every pair is counted. The per-pair phases are timed on every sampleInterval-th pair only
+//and scaled up to all pairs, which keeps the clock off the hot path.
+struct RoundProfile
+{
+    enum Phase {
+        SituationPhase, ProposePhase, ConsiderPhase, TradePhase,
+        DistributionsPhase, SaveHistoryPhase, NumPhases
+    };
+    static const size_t sampleInterval = 64;
+
+    RoundProfile();
+    void reset();
+    void merge(RoundProfile const& other);
+
+    void countPair(bool accepted, bool successful)
+    {
+        ++numPairs;
+        if (successful) {
+            ++numAccepted;
+        } else if (!accepted) {
+            ++numRejectedByConsider;
+        } else {
+            ++numRejectedByMinimum;
+        }
+    }
+    void addSample(int64_t situationNs, int64_t proposeNs, int64_t considerNs, int64_t tradeNs);
+    void addTime(Phase phase, int64_t nanoseconds) { phaseNanoseconds[phase] += nanoseconds; }
+    void addWallTime(int64_t nanoseconds) { wallNanoseconds += nanoseconds; }
+
+    static bool isPerPairPhase(Phase phase) { return phase <= TradePhase; }
+    //phases summed over the threads, per-pair phases estimated from the samples
+    double getEstimatedSeconds(Phase phase) const;
+    double getWallSeconds() const { return wallNanoseconds * 1e-9; }
+
+    uint64_t numRounds;
+    uint64_t numPairs;
+    uint64_t numAccepted;
+    uint64_t numRejectedByConsider;
+    //accepted, but traded less than the minimum sum of trade
+    uint64_t numRejectedByMinimum;
+    uint64_t numSampledPairs;
+
+private:
+    std::array<int64_t, NumPhases> phaseNanoseconds;
+    int64_t wallNanoseconds;
+};
+
+#endif // ROUNDPROFILE_H
@@ -0,0 +1,285 @@
+#include "stoppingrule.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+NoTradeStoppingRule::NoTradeStoppingRule(size_t maxRounds)
+    : maxRounds(maxRounds)
+{
+    reset();
+}
+
+void NoTradeStoppingRule::reset()
+{
+    numRoundsWithoutTrade = 0;
+}
+
+void NoTradeStoppingRule::recordRound(const RoundOutcome &round)
+{
+    numRoundsWithoutTrade = round.numSuccessful == 0 ? numRoundsWithoutTrade + 1 : 0;
+}
+
+bool NoTradeStoppingRule::isSatisfied() const
+{
+    return numRoundsWithoutTrade >= maxRounds;
+}
+
+size_t NoTradeStoppingRule::getLookBack() const
+{
+    return maxRounds;
+}
+
+std::string NoTradeStoppingRule::describe() const
+{
+    std::ostringstream description;
+    description << maxRounds << " rounds without trade";
+    return description.str();
+}
+
+UtilityChangeStoppingRule::UtilityChangeStoppingRule(size_t window, double epsilon)
+    : window(window)
+    , epsilon(epsilon)
+{
+    reset();
+}
+
+void UtilityChangeStoppingRule::reset()
+{
+    hasPrevious = false;
+    previousSumUtilities = 0.0;
+    numSteadyRounds = 0;
+}
+
+void UtilityChangeStoppingRule::recordRound(const RoundOutcome &round)
+{
+    if (hasPrevious) {
+        Amount_t const change = std::abs(round.sumUtilities - previousSumUtilities);
+        bool const steady = change <= epsilon * std::abs(previousSumUtilities);
+        numSteadyRounds = steady ? numSteadyRounds + 1 : 0;
+    }
+    hasPrevious = true;
+    previousSumUtilities = round.sumUtilities;
+}
+
+bool UtilityChangeStoppingRule::isSatisfied() const
+{
+    return numSteadyRounds >= window;
+}
+
+//the first of the window is compared to the round before it
+size_t UtilityChangeStoppingRule::getLookBack() const
+{
+    return window + 1;
+}
+
+std::string UtilityChangeStoppingRule::describe() const
+{
+    std::ostringstream description;
+    description << "sum of utilities changing less than " << epsilon << " for " << window << " rounds";
+    return description.str();
+}
+
+TradedVolumeStoppingRule::TradedVolumeStoppingRule(size_t window, double threshold)
+    : window(window)
+    , threshold(threshold)
+{
+    reset();
+}
+
+void TradedVolumeStoppingRule::reset()
+{
+    numQuietRounds = 0;
+}
+
+void TradedVolumeStoppingRule::recordRound(const RoundOutcome &round)
+{
+    numQuietRounds = round.tradedShare < threshold ? numQuietRounds + 1 : 0;
+}
+
+bool TradedVolumeStoppingRule::isSatisfied() const
+{
+    return numQuietRounds >= window;
+}
+
+size_t TradedVolumeStoppingRule::getLookBack() const
+{
+    return window;
+}
+
+std::string TradedVolumeStoppingRule::describe() const
+{
+    std::ostringstream description;
+    description << "traded share of the goods below " << threshold << " for " << window << " rounds";
+    return description.str();
+}
+
+RoundBudgetStoppingRule::RoundBudgetStoppingRule(size_t maxRounds)
+    : maxRounds(maxRounds)
+{
+    reset();
+}
+
+void RoundBudgetStoppingRule::reset()
+{
+    lastTime = 0;
+}
+
+void RoundBudgetStoppingRule::recordRound(const RoundOutcome &round)
+{
+    lastTime = round.time;
+}
+
+bool RoundBudgetStoppingRule::isSatisfied() const
+{
+    return lastTime >= maxRounds;
+}
+
+size_t RoundBudgetStoppingRule::getLookBack() const
+{
+    return 1;
+}
+
+std::string RoundBudgetStoppingRule::describe() const
+{
+    std::ostringstream description;
+    description << "round " << maxRounds << " reached";
+    return description.str();
+}
+
+WallClockBudgetStoppingRule::WallClockBudgetStoppingRule(double maxSeconds)
+    : maxSeconds(maxSeconds)
+{
+    reset();
+}
+
+void WallClockBudgetStoppingRule::reset()
+{
+    elapsedSeconds = 0.0;
+}
+
+void WallClockBudgetStoppingRule::recordRound(const RoundOutcome &round)
+{
+    elapsedSeconds += round.seconds;
+}
+
+bool WallClockBudgetStoppingRule::isSatisfied() const
+{
+    return elapsedSeconds >= maxSeconds;
+}
+
+size_t WallClockBudgetStoppingRule::getLookBack() const
+{
+    return 0;
+}
+
+std::string WallClockBudgetStoppingRule::describe() const
+{
+    std::ostringstream description;
+    description << maxSeconds << " s of simulation";
+    return description.str();
+}
+
+CompositeStoppingRule::CompositeStoppingRule(Combination combination)
+    : combination(combination)
+{
+}
+
+CompositeStoppingRule::CompositeStoppingRule(const CompositeStoppingRule &o)
+    : combination(o.combination)
+{
+    for (auto const& rule : o.rules) {
+        rules.emplace_back(rule->clone());
+    }
+}
+
+void CompositeStoppingRule::add(unique_ptr<AbstractStoppingRule> rule)
+{
+    rules.push_back(std::move(rule));
+}
+
+void CompositeStoppingRule::reset()
+{
+    for (auto const& rule : rules) {
+        rule->reset();
+    }
+}
+
+void CompositeStoppingRule::recordRound(const RoundOutcome &round)
+{
+    for (auto const& rule : rules) {
+        rule->recordRound(round);
+    }
+}
+
+bool CompositeStoppingRule::isSatisfied() const
+{
+    auto const satisfied = [](unique_ptr<AbstractStoppingRule> const& rule) { return rule->isSatisfied(); };
+    if (combination == AnyOf) {
+        return std::any_of(rules.begin(), rules.end(), satisfied);
+    }
+    return !rules.empty() && std::all_of(rules.begin(), rules.end(), satisfied);
+}
+
+size_t CompositeStoppingRule::getLookBack() const
+{
+    size_t lookBack = 0;
+    for (auto const& rule : rules) {
+        lookBack = std::max(lookBack, rule->getLookBack());
+    }
+    return lookBack;
+}
+
+std::string CompositeStoppingRule::describe() const
+{
+    bool const satisfied = isSatisfied();
+    std::string description;
+    for (auto const& rule : rules) {
+        if (satisfied && !rule->isSatisfied()) {
+            continue;
+        }
+        if (!description.empty()) {
+            description += combination == AnyOf ? " or " : " and ";
+        }
+        description += rule->describe();
+    }
+    return description;
+}
+
+StoppingCriteria::StoppingCriteria()
+    : utilityWindow(0)
+    , utilityEpsilon(0.0)
+    , volumeWindow(0)
+    , volumeThreshold(0.0)
+    , maxRounds(0)
+    , maxSeconds(0.0)
+    , requireAllConvergence(false)
+{
+}
+
+unique_ptr<AbstractStoppingRule> createStoppingRule(size_t maxRoundWithoutTrade, const StoppingCriteria &criteria)
+{
+    unique_ptr<CompositeStoppingRule> convergence(new CompositeStoppingRule(
+            criteria.requireAllConvergence ? CompositeStoppingRule::AllOf : CompositeStoppingRule::AnyOf));
+    if (criteria.utilityWindow > 0) {
+        convergence->add(unique_ptr<AbstractStoppingRule>(
+                             new UtilityChangeStoppingRule(criteria.utilityWindow, criteria.utilityEpsilon)));
+    }
+    if (criteria.volumeWindow > 0) {
+        convergence->add(unique_ptr<AbstractStoppingRule>(
+                             new TradedVolumeStoppingRule(criteria.volumeWindow, criteria.volumeThreshold)));
+    }
+
+    unique_ptr<CompositeStoppingRule> rule(new CompositeStoppingRule(CompositeStoppingRule::AnyOf));
+    rule->add(unique_ptr<AbstractStoppingRule>(new NoTradeStoppingRule(maxRoundWithoutTrade)));
+    if (criteria.maxRounds > 0) {
+        rule->add(unique_ptr<AbstractStoppingRule>(new RoundBudgetStoppingRule(criteria.maxRounds)));
+    }
+    if (criteria.maxSeconds > 0.0) {
+        rule->add(unique_ptr<AbstractStoppingRule>(new WallClockBudgetStoppingRule(criteria.maxSeconds)));
+    }
+    if (!convergence->isEmpty()) {
+        rule->add(std::move(convergence));
+    }
+    return unique_ptr<AbstractStoppingRule>(rule.release());
+}
@@ -0,0 +1,163 @@
+#ifndef STOPPINGRULE_H
+#define STOPPINGRULE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "modelutils.h"
+
+using std::unique_ptr;
+
+//What the stopping rules learn of a closed round
+struct RoundOutcome
+{
+    size_t time;
+    Amount_t numSuccessful;
+    //share of the goods that changed hands: (q1Traded/sumQ1 + q2Traded/sumQ2) / 2
+    Amount_t tradedShare;
+    Amount_t sumUtilities;
+    //wall time of the round, zero for the rounds replayed from the history
+    double seconds;
+};
+
+//Decides whether a simulation has its answer. A rule keeps O(1) state updated once per closed round,
+//so asking it costs nothing. The history keeps the last getLookBack() rounds in full, which are
+//replayed into a fresh rule when the rules change or a checkpoint is loaded.
+struct AbstractStoppingRule
+{
+    virtual AbstractStoppingRule* clone() const = 0;
+    virtual void reset() = 0;
+    virtual void recordRound(RoundOutcome const& round) = 0;
+    virtual bool isSatisfied() const = 0;
+    virtual size_t getLookBack() const = 0;
+    //the condition of the rule, of a satisfied composite the conditions met
+    virtual std::string describe() const = 0;
+    virtual ~AbstractStoppingRule(){}
+};
+
+//maxRounds consecutive rounds without a successful trade
+struct NoTradeStoppingRule final: AbstractStoppingRule
+{
+    explicit NoTradeStoppingRule(size_t maxRounds);
+    CLONEABLE(NoTradeStoppingRule)
+    virtual void reset() override;
+    virtual void recordRound(RoundOutcome const& round) override;
+    virtual bool isSatisfied() const override;
+    virtual size_t getLookBack() const override;
+    virtual std::string describe() const override;
+
+private:
+    size_t maxRounds;
+    size_t numRoundsWithoutTrade;
+};
+
+//the sum of utilities changed by less than epsilon (relative to it) in each of window consecutive rounds
+struct UtilityChangeStoppingRule final: AbstractStoppingRule
+{
+    UtilityChangeStoppingRule(size_t window, double epsilon);
+    CLONEABLE(UtilityChangeStoppingRule)
+    virtual void reset() override;
+    virtual void recordRound(RoundOutcome const& round) override;
+    virtual bool isSatisfied() const override;
+    virtual size_t getLookBack() const override;
+    virtual std::string describe() const override;
+
+private:
+    size_t window;
+    double epsilon;
+    bool hasPrevious;
+    Amount_t previousSumUtilities;
+    size_t numSteadyRounds;
+};
+
+//the traded share of the goods stayed below threshold in window consecutive rounds
+struct TradedVolumeStoppingRule final: AbstractStoppingRule
+{
+    TradedVolumeStoppingRule(size_t window, double threshold);
+    CLONEABLE(TradedVolumeStoppingRule)
+    virtual void reset() override;
+    virtual void recordRound(RoundOutcome const& round) override;
+    virtual bool isSatisfied() const override;
+    virtual size_t getLookBack() const override;
+    virtual std::string describe() const override;
+
+private:
+    size_t window;
+    double threshold;
+    size_t numQuietRounds;
+};
+
+//the simulation reached round maxRounds
+struct RoundBudgetStoppingRule final: AbstractStoppingRule
+{
+    explicit RoundBudgetStoppingRule(size_t maxRounds);
+    CLONEABLE(RoundBudgetStoppingRule)
+    virtual void reset() override;
+    virtual void recordRound(RoundOutcome const& round) override;
+    virtual bool isSatisfied() const override;
+    virtual size_t getLookBack() const override;
+    virtual std::string describe() const override;
+
+private:
+    size_t maxRounds;
+    size_t lastTime;
+};
+
+//the rounds took maxSeconds of wall time, counted since the rule was set up
+struct WallClockBudgetStoppingRule final: AbstractStoppingRule
+{
+    explicit WallClockBudgetStoppingRule(double maxSeconds);
+    CLONEABLE(WallClockBudgetStoppingRule)
+    virtual void reset() override;
+    virtual void recordRound(RoundOutcome const& round) override;
+    virtual bool isSatisfied() const override;
+    virtual size_t getLookBack() const override;
+    virtual std::string describe() const override;
+
+private:
+    double maxSeconds;
+    double elapsedSeconds;
+};
+
+//Satisfied when any (or all) of its rules are
+struct CompositeStoppingRule final: AbstractStoppingRule
+{
+    enum Combination { AnyOf, AllOf };
+
+    explicit CompositeStoppingRule(Combination combination);
+    CompositeStoppingRule(CompositeStoppingRule const& o);
+    CLONEABLE(CompositeStoppingRule)
+    void add(unique_ptr<AbstractStoppingRule> rule);
+    bool isEmpty() const { return rules.empty(); }
+
+    virtual void reset() override;
+    virtual void recordRound(RoundOutcome const& round) override;
+    virtual bool isSatisfied() const override;
+    virtual size_t getLookBack() const override;
+    virtual std::string describe() const override;
+
+private:
+    Combination combination;
+    std::vector<unique_ptr<AbstractStoppingRule>> rules;
+};
+
+//Stopping rules besides the rounds without trade, 0 disables each of them
+struct StoppingCriteria
+{
+    StoppingCriteria();
+
+    size_t utilityWindow;
+    double utilityEpsilon;
+    size_t volumeWindow;
+    double volumeThreshold;
+    size_t maxRounds;
+    double maxSeconds;
+    //the convergence rules (utility change, traded volume) must all be met, not just one
+    bool requireAllConvergence;
+};
+
+//Stops at the rounds without trade, at either budget or when the convergence rules are met
+unique_ptr<AbstractStoppingRule> createStoppingRule(size_t maxRoundWithoutTrade, StoppingCriteria const& criteria);
+
+#endif // STOPPINGRULE_H
@@ -1,5 +1,6 @@
 #include "strategy.h"
 #include "model.h"
+#include "tradeengine.h"
 
 Position OppositeParetoOfferStrategy::propose(EdgeworthSituation const& situation, URNG&) const
 {
@@ -49,8 +50,8 @@ bool AlwaysAcceptanceStrategy::consider(EdgeworthSituation const&) const
     return true;
 }
 
-bool AbstractAcceptanceStrategy::considerGeneral(EdgeworthSituation const& situation,
-                                          std::function<Amount_t(const Amount_t &, const Amount_t &)> evaluate) const
+template<typename Evaluate>
+bool AbstractAcceptanceStrategy::considerGeneral(EdgeworthSituation const& situation, Evaluate evaluate) const
 {
     auto const actor1Utility = situation.calculateOriginalUtility(situation.actor1);
     auto const actor2Utility = situation.calculateOriginalUtility(situation.actor2);
@@ -76,3 +77,149 @@ bool HigherProportionAcceptanceStrategy::consider(EdgeworthSituation const& situ
         return newUtility / originalUtility;
     });
 }
+
+//The engine lives next to the strategies, so their (final) propose and consider inline into the trade loop.
+namespace {
+
+//Stand in for the strategies on the sampled pairs, adding the time of their calls to a phase
+template<typename OfferStrategy>
+struct TimedOfferStrategy
+{
+    OfferStrategy const& strategy;
+    int64_t& nanoseconds;
+
+    Position propose(EdgeworthSituation const& situation, URNG& rng) const
+    {
+        int64_t const start = profileClockNow();
+        Position const result = strategy.propose(situation, rng);
+        nanoseconds += profileClockNow() - start;
+        return result;
+    }
+};
+
+template<typename AcceptanceStrategy>
+struct TimedAcceptanceStrategy
+{
+    AcceptanceStrategy const& strategy;
+    int64_t& nanoseconds;
+
+    bool consider(EdgeworthSituation const& situation) const
+    {
+        int64_t const start = profileClockNow();
+        bool const result = strategy.consider(situation);
+        nanoseconds += profileClockNow() - start;
+        return result;
+    }
+};
+
+template<typename OfferStrategy, typename AcceptanceStrategy>
+struct TradeEngine: AbstractTradeEngine
+{
+    TradeEngine(OfferStrategy const& offerStrategy, AcceptanceStrategy const& acceptanceStrategy)
+        : offerStrategy(offerStrategy)
+        , acceptanceStrategy(acceptanceStrategy)
+    {}
+
+    virtual bool isSelectedFor(AbstractOfferStrategy const* offer, AbstractAcceptanceStrategy const* acceptance) const override
+    {
+        return offer == &offerStrategy && acceptance == &acceptanceStrategy;
+    }
+
+    virtual void tradePairs(Simulation& simulation, size_t beginPair, size_t endPair,
+                            Simulation::RoundInfo& info, Simulation::ActorChanges& changes,
+                            RoundProfile& profile) const override
+    {
+        for (size_t pairIdx = beginPair; pairIdx < endPair; ++pairIdx) {
+            size_t actor1Idx, actor2Idx;
+            std::tie(actor1Idx, actor2Idx) = simulation.progress.getPair(pairIdx);
+            URNG rng = simulation.createTradeStream(pairIdx);
+            if (pairIdx % RoundProfile::sampleInterval == 0) {
+                tradeSampledPair(simulation, actor1Idx, actor2Idx, rng, info, changes, profile);
+                continue;
+            }
+            EdgeworthSituation const situation(simulation, actor1Idx, actor2Idx,
+                                               offerStrategy, acceptanceStrategy, rng);
+            if (situation.successful) {
+                info.recordTrade(simulation.trade(situation, actor1Idx, actor2Idx, changes));
+            }
+            profile.countPair(situation.accepted, situation.successful);
+        }
+    }
+
+private:
+    //Trades exactly as the other pairs do, with the phases timed
+    void tradeSampledPair(Simulation& simulation, size_t actor1Idx, size_t actor2Idx, URNG& rng,
+                          Simulation::RoundInfo& info, Simulation::ActorChanges& changes,
+                          RoundProfile& profile) const
+    {
+        int64_t proposeNs = 0;
+        int64_t considerNs = 0;
+        TimedOfferStrategy<OfferStrategy> const timedOffer{offerStrategy, proposeNs};
+        TimedAcceptanceStrategy<AcceptanceStrategy> const timedAcceptance{acceptanceStrategy, considerNs};
+        int64_t const start = profileClockNow();
+        EdgeworthSituation const situation(simulation, actor1Idx, actor2Idx, timedOffer, timedAcceptance, rng);
+        int64_t const situationEnd = profileClockNow();
+        if (situation.successful) {
+            info.recordTrade(simulation.trade(situation, actor1Idx, actor2Idx, changes));
+        }
+        int64_t const tradeEnd = profileClockNow();
+        profile.addSample(situationEnd - start - proposeNs - considerNs, proposeNs, considerNs, tradeEnd - situationEnd);
+        profile.countPair(situation.accepted, situation.successful);
+    }
+
+    OfferStrategy const& offerStrategy;
+    AcceptanceStrategy const& acceptanceStrategy;
+};
+
+template<typename OfferStrategy>
+struct AcceptanceSelector: IAcceptanceStrategyVisitor
+{
+    AcceptanceSelector(OfferStrategy const& offerStrategy): offerStrategy(offerStrategy) {}
+
+    virtual void visit(AlwaysAcceptanceStrategy& s) override { select(s); }
+    virtual void visit(HigherGainAcceptanceStrategy& s) override { select(s); }
+    virtual void visit(HigherProportionAcceptanceStrategy& s) override { select(s); }
+
+    unique_ptr<AbstractTradeEngine> engine;
+
+private:
+    template<typename AcceptanceStrategy>
+    void select(AcceptanceStrategy const& acceptanceStrategy)
+    {
+        engine.reset(new TradeEngine<OfferStrategy, AcceptanceStrategy>(offerStrategy, acceptanceStrategy));
+    }
+
+    OfferStrategy const& offerStrategy;
+};
+
+struct OfferSelector: IOfferStrategyVisitor
+{
+    OfferSelector(AbstractAcceptanceStrategy& acceptanceStrategy): acceptanceStrategy(acceptanceStrategy) {}
+
+    virtual void visit(OppositeParetoOfferStrategy& s) override { select(s); }
+    virtual void visit(RandomParetoOfferStrategy& s) override { select(s); }
+    virtual void visit(RandomTriangleOfferStrategy& s) override { select(s); }
+
+    unique_ptr<AbstractTradeEngine> engine;
+
+private:
+    template<typename OfferStrategy>
+    void select(OfferStrategy const& offerStrategy)
+    {
+        AcceptanceSelector<OfferStrategy> acceptanceSelector(offerStrategy);
+        acceptanceStrategy.accept(acceptanceSelector);
+        engine = std::move(acceptanceSelector.engine);
+    }
+
+    AbstractAcceptanceStrategy& acceptanceStrategy;
+};
+
+}
+
+unique_ptr<AbstractTradeEngine> createTradeEngine(AbstractOfferStrategy& offerStrategy,
+                                                  AbstractAcceptanceStrategy& acceptanceStrategy)
+{
+    OfferSelector offerSelector(acceptanceStrategy);
+    offerStrategy.accept(offerSelector);
+    return std::move(offerSelector.engine);
+}
@@ -24,7 +24,7 @@ struct AbstractOfferStrategy
     virtual ~AbstractOfferStrategy(){}
 };
 
-struct OppositeParetoOfferStrategy: AbstractOfferStrategy
+struct OppositeParetoOfferStrategy final: AbstractOfferStrategy
 {
     CLONEABLE(OppositeParetoOfferStrategy)
     VISITABLE_BY(IOfferStrategyVisitor)
@@ -32,7 +32,7 @@ struct OppositeParetoOfferStrategy: AbstractOfferStrategy
     virtual ~OppositeParetoOfferStrategy() {}
 };
 
-struct RandomParetoOfferStrategy: AbstractOfferStrategy
+struct RandomParetoOfferStrategy final: AbstractOfferStrategy
 {
     CLONEABLE(RandomParetoOfferStrategy)
     VISITABLE_BY(IOfferStrategyVisitor)
@@ -40,7 +40,7 @@ struct RandomParetoOfferStrategy: AbstractOfferStrategy
     virtual ~RandomParetoOfferStrategy() {}
 };
 
-struct RandomTriangleOfferStrategy: AbstractOfferStrategy
+struct RandomTriangleOfferStrategy final: AbstractOfferStrategy
 {
     CLONEABLE(RandomTriangleOfferStrategy)
     VISITABLE_BY(IOfferStrategyVisitor)
@@ -65,11 +65,11 @@ struct AbstractAcceptanceStrategy
     virtual void accept(IAcceptanceStrategyVisitor& v) = 0;
     virtual bool consider(EdgeworthSituation const& situation) const = 0;
     virtual ~AbstractAcceptanceStrategy(){}
-    bool considerGeneral(const EdgeworthSituation &situation,
-                         std::function<Amount_t(Amount_t const&, Amount_t const&)> evaluate) const;
+    template<typename Evaluate>
+    bool considerGeneral(const EdgeworthSituation &situation, Evaluate evaluate) const;
 };
 
-struct AlwaysAcceptanceStrategy: AbstractAcceptanceStrategy
+struct AlwaysAcceptanceStrategy final: AbstractAcceptanceStrategy
 {
     CLONEABLE(AlwaysAcceptanceStrategy)
     VISITABLE_BY(IAcceptanceStrategyVisitor)
@@ -77,7 +77,7 @@ struct AlwaysAcceptanceStrategy: AbstractAcceptanceStrategy
     virtual ~AlwaysAcceptanceStrategy(){}
 };
 
-struct HigherGainAcceptanceStrategy: AbstractAcceptanceStrategy
+struct HigherGainAcceptanceStrategy final: AbstractAcceptanceStrategy
 {
     CLONEABLE(HigherGainAcceptanceStrategy)
     VISITABLE_BY(IAcceptanceStrategyVisitor)
@@ -85,7 +85,7 @@ struct HigherGainAcceptanceStrategy: AbstractAcceptanceStrategy
     virtual ~HigherGainAcceptanceStrategy(){}
 };
 
-struct HigherProportionAcceptanceStrategy: AbstractAcceptanceStrategy
+struct HigherProportionAcceptanceStrategy final: AbstractAcceptanceStrategy
 {
     CLONEABLE(HigherProportionAcceptanceStrategy)
     VISITABLE_BY(IAcceptanceStrategyVisitor)
@@ -0,0 +1,83 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(size_t numThreads)
+    : currentTask(nullptr)
+    , numTasks(0)
+    , nextTaskIdx(0)
+    , numActiveWorkers(0)
+    , generation(0)
+    , stopping(false)
+{
+    for (size_t idx = 1; idx < numThreads; ++idx) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startCondition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t numTasks, const Task &task)
+{
+    if (workers.empty() || numTasks < 2) {
+        for (size_t taskIdx = 0; taskIdx < numTasks; ++taskIdx) {
+            task(taskIdx);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = &task;
+        this->numTasks = numTasks;
+        nextTaskIdx = 0;
+        numActiveWorkers = workers.size();
+        ++generation;
+    }
+    startCondition.notify_all();
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this](){ return numActiveWorkers == 0; });
+    currentTask = nullptr;
+}
+
+void ThreadPool::workerLoop()
+{
+    size_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCondition.wait(lock, [&](){ return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+        runTasks();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--numActiveWorkers == 0) {
+                doneCondition.notify_all();
+            }
+        }
+    }
+}
+
+void ThreadPool::runTasks()
+{
+    for (;;) {
+        size_t const taskIdx = nextTaskIdx++;
+        if (taskIdx >= numTasks) {
+            return;
+        }
+        (*currentTask)(taskIdx);
+    }
+}
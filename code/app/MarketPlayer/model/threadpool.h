@@ -0,0 +1,46 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of workers executing index ranges.
+//The calling thread takes part in the work, so a pool of one thread has no workers at all.
+struct ThreadPool
+{
+    typedef std::function<void(size_t taskIdx)> Task;
+
+    explicit ThreadPool(size_t numThreads);
+    ~ThreadPool();
+
+    size_t getNumThreads() const { return workers.size() + 1; }
+
+    //Runs task(0) .. task(numTasks-1) and returns when all of them finished.
+    //Tasks may run in any order and on any thread.
+    void parallelFor(size_t numTasks, Task const& task);
+
+private:
+    ThreadPool(ThreadPool const&);
+    ThreadPool& operator=(ThreadPool const&);
+
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+
+    Task const* currentTask;
+    size_t numTasks;
+    std::atomic<size_t> nextTaskIdx;
+    size_t numActiveWorkers;
+    size_t generation;
+    bool stopping;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,22 @@
+#ifndef TRADEENGINE_H
+#define TRADEENGINE_H
+
+#include "model.h"
+
+//Trades a range of pairs of the current round with one (offer, acceptance) combination
+//resolved at compile time: there is a single virtual call per range instead of two per pair.
+struct AbstractTradeEngine
+{
+    virtual bool isSelectedFor(AbstractOfferStrategy const* offerStrategy,
+                               AbstractAcceptanceStrategy const* acceptanceStrategy) const = 0;
+    virtual void tradePairs(Simulation& simulation, size_t beginPair, size_t endPair,
+                            Simulation::RoundInfo& info, Simulation::ActorChanges& changes,
+                            RoundProfile& profile) const = 0;
+    virtual ~AbstractTradeEngine(){}
+};
+
+//Selects the engine instance by visiting both strategies
+unique_ptr<AbstractTradeEngine> createTradeEngine(AbstractOfferStrategy& offerStrategy,
+                                                  AbstractAcceptanceStrategy& acceptanceStrategy);
+
+#endif // TRADEENGINE_H
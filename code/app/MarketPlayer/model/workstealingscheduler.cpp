@@ -0,0 +1,69 @@
+#include "workstealingscheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+WorkStealingScheduler::WorkStealingScheduler(size_t numThreads)
+{
+    for (size_t idx = 0; idx < std::max<size_t>(numThreads, 1); ++idx) {
+        queues.emplace_back(new TaskQueue());
+    }
+}
+
+//Each thread starts with a contiguous range of the tasks, neighbouring tasks tend to be alike
+void WorkStealingScheduler::run(size_t numTasks, const Task &task)
+{
+    size_t const numThreads = queues.size();
+    for (size_t threadIdx = 0; threadIdx < numThreads; ++threadIdx) {
+        auto& taskIndices = queues[threadIdx]->taskIndices;
+        taskIndices.clear();
+        for (size_t taskIdx = numTasks * threadIdx / numThreads; taskIdx < numTasks * (threadIdx + 1) / numThreads; ++taskIdx) {
+            taskIndices.push_front(taskIdx);
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t threadIdx = 1; threadIdx < numThreads && threadIdx < numTasks; ++threadIdx) {
+        threads.emplace_back(&WorkStealingScheduler::work, this, threadIdx, std::cref(task));
+    }
+    work(0, task);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+//No task is added while running, so once a thread finds every queue empty it is done
+void WorkStealingScheduler::work(size_t threadIdx, const Task &task)
+{
+    size_t taskIdx;
+    while (takeOwn(threadIdx, taskIdx) || steal(threadIdx, taskIdx)) {
+        task(taskIdx);
+    }
+}
+
+bool WorkStealingScheduler::takeOwn(size_t threadIdx, size_t &taskIdx)
+{
+    TaskQueue& queue = *queues[threadIdx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.taskIndices.empty()) {
+        return false;
+    }
+    taskIdx = queue.taskIndices.back();
+    queue.taskIndices.pop_back();
+    return true;
+}
+
+bool WorkStealingScheduler::steal(size_t thiefIdx, size_t &taskIdx)
+{
+    size_t const numThreads = queues.size();
+    for (size_t offset = 1; offset < numThreads; ++offset) {
+        TaskQueue& victim = *queues[(thiefIdx + offset) % numThreads];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.taskIndices.empty()) {
+            taskIdx = victim.taskIndices.front();
+            victim.taskIndices.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
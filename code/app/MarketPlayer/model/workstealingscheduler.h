@@ -0,0 +1,43 @@
+#ifndef WORKSTEALINGSCHEDULER_H
+#define WORKSTEALINGSCHEDULER_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//Runs independent tasks of widely varying length, e.g. whole simulations, on a fixed number of threads.
+//Every thread owns a queue of tasks: it takes them from the back of its own queue and,
+//once that is empty, steals from the front of the others', so no thread idles while tasks are left.
+//The calling thread is one of the threads.
+struct WorkStealingScheduler
+{
+    typedef std::function<void(size_t taskIdx)> Task;
+
+    explicit WorkStealingScheduler(size_t numThreads);
+
+    size_t getNumThreads() const { return queues.size(); }
+
+    //Runs task(0) .. task(numTasks-1) and returns when all of them finished.
+    //Tasks may run in any order and on any thread.
+    void run(size_t numTasks, Task const& task);
+
+private:
+    WorkStealingScheduler(WorkStealingScheduler const&);
+    WorkStealingScheduler& operator=(WorkStealingScheduler const&);
+
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<size_t> taskIndices;
+    };
+
+    void work(size_t threadIdx, Task const& task);
+    bool takeOwn(size_t threadIdx, size_t& taskIdx);
+    bool steal(size_t thiefIdx, size_t& taskIdx);
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+};
+
+#endif // WORKSTEALINGSCHEDULER_H
@@ -2,6 +2,8 @@
 #include "plotutils.h"
 #include "bundlehelper.h"
 
+#include <algorithm>
+
 using std::unique_ptr;
 using std::map;
 
@@ -9,9 +11,19 @@ DataTimePlot::DataTimePlot(QCustomPlot* plot, QLabel *label, QString yLabel, QSt
     : Plot(plot)
     , label(label)
     , labelPrefix(labelPrefix)
+    , isFollowingRun(true)
+    , isSettingRange(false)
 {
     plot->xAxis->setLabel("Time");
     plot->yAxis->setLabel(yLabel);
+
+    plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    plot->axisRect()->setRangeDrag(Qt::Horizontal);
+    plot->axisRect()->setRangeZoom(Qt::Horizontal);
+    connect(plot->xAxis, SIGNAL(rangeChanged(QCPRange)),
+            this, SLOT(onXRangeChanged(QCPRange)));
+    connect(plot, SIGNAL(mouseDoubleClick(QMouseEvent*)),
+            this, SLOT(onMouseDoubleClick(QMouseEvent*)));
 }
 
 void DataTimePlot::update()
@@ -27,8 +39,13 @@ void DataTimePlot::update()
                     [](BundlePtr const& bundle){ return bundle->getYMax(); }
         );
 
-        plot->xAxis->setRange(0.0, xLast + 1);
+        isSettingRange = true;
+        if (isFollowingRun) {
+            plot->xAxis->setRange(0.0, xLast + 1);
+        }
         plot->yAxis->setRange(0.0, yMax * 1.1);
+        isSettingRange = false;
+        updateGraphs();
     }
     plot->replot();
 
@@ -47,6 +64,29 @@ void DataTimePlot::clearData()
     }
 }
 
+//The plot replots itself after the zoom or the drag
+void DataTimePlot::onXRangeChanged(const QCPRange &)
+{
+    if (!isSettingRange) {
+        isFollowingRun = false;
+        updateGraphs();
+    }
+}
+
+void DataTimePlot::onMouseDoubleClick(QMouseEvent *)
+{
+    isFollowingRun = true;
+    update();
+}
+
+void DataTimePlot::updateGraphs()
+{
+    size_t const numColumns = std::max(1, plot->axisRect()->width());
+    for (auto& bundle : bundles) {
+        bundle.second->updateGraph(plot->xAxis->range(), numColumns);
+    }
+}
+
 DataTimePlottableBundle *DataTimePlot::provideBundle(QString bundleKey)
 {
     return BundleHelper::provideBundleHelper<DataTimePlottableBundle>(bundleKey, bundles, plot);
@@ -10,8 +10,11 @@
 #include "plot.h"
 #include "datatimeplottablebundle.h"
 
-class DataTimePlot : public Plot
+//The time axis follows the whole run until the user zooms or drags it, a double click returns to following
+class DataTimePlot : public QObject, public Plot
 {
+    Q_OBJECT
+
 public:
     DataTimePlot(QCustomPlot* plot, QLabel *label, QString yLabel, QString labelPrefix);
     virtual void update();
@@ -21,13 +24,21 @@ public:
     virtual DataTimePlottableBundle* provideBundle(QString bundleKey);
     void dropBundle(QString bundleKey);
 
+private slots:
+    void onXRangeChanged(QCPRange const& range);
+    void onMouseDoubleClick(QMouseEvent* event);
+
 protected:
+    void updateGraphs();
+
     QLabel* label;
     QString labelPrefix;
 
     //DataTimePlottableBundle must not outlive the plot
     typedef std::map<QString, std::unique_ptr<DataTimePlottableBundle>> BundleMap;
     BundleMap bundles;
+    bool isFollowingRun;
+    bool isSettingRange;
 };
 
 #endif // DATATIMEPLOT_H
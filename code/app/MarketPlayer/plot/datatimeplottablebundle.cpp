@@ -1,8 +1,27 @@
 #include "datatimeplottablebundle.h"
 
+#include <algorithm>
+
 DataTimePlottableBundle::DataTimePlottableBundle(QCustomPlot *plot)
     : PlottableBundle(plot)
+    , numPushed(0)
+    , decimatedSize(0)
+    , bandXLast(0.0)
+    , bandYMax(0.0)
 {
+    //added first to stay beneath the data
+    bandLowerGraph = plot->addGraph();
+    addPlottable(bandLowerGraph, FixColor);
+    bandLowerGraph->setPen(Qt::NoPen);
+    bandUpperGraph = plot->addGraph();
+    addPlottable(bandUpperGraph, DynamicFill);
+    bandUpperGraph->setChannelFillGraph(bandLowerGraph);
+    bandMeanGraph = plot->addGraph();
+    addPlottable(bandMeanGraph, DynamicColor);
+    auto meanPen = bandMeanGraph->pen();
+    meanPen.setStyle(Qt::DashLine);
+    bandMeanGraph->setPen(meanPen);
+
     dataGraph = plot->addGraph();
     addPlottable(dataGraph, DynamicColor);
 
@@ -19,34 +38,97 @@ DataTimePlottableBundle::DataTimePlottableBundle(QCustomPlot *plot)
 void DataTimePlottableBundle::removeSelf()
 {
     PlottableBundle::removeSelf();
+    bandLowerGraph = nullptr;
+    bandUpperGraph = nullptr;
+    bandMeanGraph = nullptr;
     dataGraph = nullptr;
     currentPointGraph = nullptr;
 }
 
 void DataTimePlottableBundle::updateData(const DataTimePair &dataTime, int currentIdx)
 {
-    dataGraph->setData(dataTime.data.x, dataTime.data.y);
+    //The times are increasing and thinning only drops points, so the new series extends the old one
+    //as long as the last old point is still at its place
+    bool const isExtension = series.size() > 0 && series.size() <= dataTime.size()
+            && dataTime.getX(series.size() - 1) == series.getLastX();
+    if (!isExtension) {
+        pyramid.clear();
+        numPushed = 0;
+        decimatedSize = 0;
+    }
+    series = dataTime;
+    pyramid.extend(series);
 
     //if out of range:
     if (currentIdx >= dataTime.size()) {
         currentIdx = dataTime.size() - 1;
     }
     currentPointGraph->clearData();
-    currentPointGraph->addData(currentIdx, dataTime[currentIdx]);
+    currentPointGraph->addData(dataTime.getX(currentIdx), dataTime[currentIdx]);
 
-    xLast = dataTime.data.x.last();
+    xLast = dataTime.getLastX();
     yMax = dataTime.max;
     currentValue = dataTime[currentIdx];
 }
 
+void DataTimePlottableBundle::resetData()
+{
+    series.reset();
+}
+
+void DataTimePlottableBundle::updateGraph(const QCPRange &xRange, size_t numColumns)
+{
+    if (series.size() <= 2 * numColumns) {
+        //a graph cleared from outside is rebuilt too
+        bool const canAppend = numPushed > 0 && static_cast<size_t>(dataGraph->data()->size()) == numPushed;
+        if (canAppend) {
+            for (size_t idx = numPushed; idx < series.size(); ++idx) {
+                dataGraph->addData(series.getX(idx), series[idx]);
+            }
+        } else {
+            ResourceDataPair const data = series.toDataPair();
+            dataGraph->setData(data.x, data.y);
+        }
+        numPushed = series.size();
+        decimatedSize = 0;
+        return;
+    }
+
+    //one point beyond each end of the range keeps the line running to the border
+    size_t firstIdx = series.findNearestIdx(xRange.lower);
+    size_t lastIdx = series.findNearestIdx(xRange.upper);
+    firstIdx = firstIdx > 0 ? firstIdx - 1 : 0;
+    lastIdx = std::min(lastIdx + 1, series.size() - 1);
+    bool const isShown = decimatedSize == series.size() && decimatedFirstIdx == firstIdx
+            && decimatedLastIdx == lastIdx && decimatedNumColumns == numColumns;
+    if (!isShown) {
+        pyramid.decimate(series, firstIdx, lastIdx, numColumns, decimated);
+        dataGraph->setData(decimated.x, decimated.y);
+        numPushed = 0;
+        decimatedSize = series.size();
+        decimatedFirstIdx = firstIdx;
+        decimatedLastIdx = lastIdx;
+        decimatedNumColumns = numColumns;
+    }
+}
+
+void DataTimePlottableBundle::setBand(const EnsembleBand &band)
+{
+    bandLowerGraph->setData(band.lower.x, band.lower.y);
+    bandUpperGraph->setData(band.upper.x, band.upper.y);
+    bandMeanGraph->setData(band.mean.x, band.mean.y);
+    bandXLast = band.upper.size() > 0 ? band.upper.x.back() : 0.0;
+    bandYMax = band.upper.size() > 0 ? *std::max_element(band.upper.y.begin(), band.upper.y.end()) : 0.0;
+}
+
 Amount_t DataTimePlottableBundle::getXLast() const
 {
-    return xLast;
+    return std::max(xLast, bandXLast);
 }
 
 Amount_t DataTimePlottableBundle::getYMax() const
 {
-    return yMax;
+    return std::max(yMax, bandYMax);
 }
 
 Amount_t DataTimePlottableBundle::getCurrentValue() const
@@ -3,6 +3,8 @@
 
 #include "plottablebundle.h"
 #include "modelutils.h"
+#include "ensemble.h"
+#include "minmaxpyramid.h"
 
 class QCustomPlot;
 
@@ -10,16 +12,39 @@ struct DataTimePlottableBundle : public PlottableBundle
 {
     DataTimePlottableBundle(QCustomPlot* plot);
     virtual void removeSelf() override;
+    //takes the series, the graph follows on updateGraph
     void updateData(DataTimePair const& dataTime, int currentIdx);
+    //the next update rebuilds the graph, for a series replaced by another one
+    void resetData();
+    //Shows the part of the series in xRange on numColumns pixels. A short series is kept whole in the graph
+    //and only the new points are appended, a long one is decimated to the extremes of each column.
+    void updateGraph(QCPRange const& xRange, size_t numColumns);
+    //shaded envelope with its mean dashed, an empty band hides it
+    void setBand(EnsembleBand const& band);
     Amount_t getXLast() const;
     Amount_t getYMax() const;
     Amount_t getCurrentValue() const;
 
 private:
+    QCPGraph* bandLowerGraph;
+    QCPGraph* bandUpperGraph;
+    QCPGraph* bandMeanGraph;
     QCPGraph* dataGraph;
     QCPGraph* currentPointGraph;
+    //copies share the points, so keeping the series costs O(chunks)
+    DataTimePair series;
+    MinMaxPyramid pyramid;
+    //points of the series in the graph when it holds a prefix of it, 0 otherwise
+    size_t numPushed;
+    ResourceDataPair decimated;
+    size_t decimatedFirstIdx;
+    size_t decimatedLastIdx;
+    size_t decimatedNumColumns;
+    size_t decimatedSize;
     Amount_t xLast;
     Amount_t yMax;
+    Amount_t bandXLast;
+    Amount_t bandYMax;
     Amount_t currentValue;
 };
 
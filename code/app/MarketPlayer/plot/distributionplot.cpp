@@ -2,6 +2,9 @@
 #include "plotutils.h"
 #include "bundlehelper.h"
 
+#include <algorithm>
+#include <limits>
+
 DistributionPlot::DistributionPlot(QCustomPlot* plot, QString xLabel, QString yLabel)
     : Plot(plot)
 {
@@ -21,8 +24,22 @@ void DistributionPlot::update()
                     bundles,
                     [](BundlePtr const& bundle){ return bundle->getMaxNum(); }
         );
+        //a case with linear buckets has its first bucket at 0, which a log axis can not show
+        bool const isLogScale = std::all_of(bundles.begin(), bundles.end(), [](BundleMap::value_type const& entry) {
+            return entry.second->isLogScale();
+        });
 
-        plot->xAxis->setRange(0.0, xLast * 1.1);
+        if (isLogScale) {
+            Amount_t xFirst = std::numeric_limits<Amount_t>::max();
+            for (auto const& entry : bundles) {
+                xFirst = std::min(xFirst, entry.second->getXFirst());
+            }
+            plot->xAxis->setScaleType(QCPAxis::stLogarithmic);
+            plot->xAxis->setRange(xFirst, xLast * 1.1);
+        } else {
+            plot->xAxis->setScaleType(QCPAxis::stLinear);
+            plot->xAxis->setRange(0.0, xLast * 1.1);
+        }
         plot->yAxis->setRange(0.0, maxNum * 1.1);
     }
 
@@ -2,34 +2,72 @@
 
 DistributionPlottableBundle::DistributionPlottableBundle(QCustomPlot *plot)
     : PlottableBundle(plot)
+    , xFirst(0.0)
+    , xLast(0.0)
+    , maxNum(0.0)
+    , logScale(false)
 {
     bars = new QCPBars(plot->xAxis, plot->yAxis);
     plot->addPlottable(bars);
     addPlottable(bars, DynamicColor);
+
+    steps = new QCPGraph(plot->xAxis, plot->yAxis);
+    steps->setLineStyle(QCPGraph::lsStepLeft);
+    plot->addPlottable(steps);
+    addPlottable(steps, DynamicColor);
 }
 
 void DistributionPlottableBundle::removeSelf()
 {
     PlottableBundle::removeSelf();
     bars = nullptr;
+    steps = nullptr;
 }
 
 void DistributionPlottableBundle::updateData(const HeavyDistribution &distribution)
 {
     auto const& data = distribution.data;
+    auto const& layout = distribution.layout;
+    logScale = layout.scale == HistogramLayout::LogScale;
 
-    bars->setWidth(distribution.resolution);
-    bars->setData(data.x, data.y);
-
-    xLast = data.x.last();
+    if (logScale) {
+        bars->clearData();
+        //each count starts at the lower edge of its bucket, the last one is closed at its upper edge
+        edges.reset();
+        for (size_t idx = 0; idx < distribution.numBuckets; ++idx) {
+            edges.push(layout.getLowerEdge(idx), data.y[idx]);
+        }
+        if (distribution.numBuckets > 0) {
+            edges.push(distribution.maxSubject, data.y.last());
+        }
+        steps->setData(edges.x, edges.y);
+        xFirst = layout.getLowerEdge(0);
+        xLast = distribution.maxSubject;
+    } else {
+        steps->clearData();
+        bars->setWidth(layout.resolution);
+        bars->setData(data.x, data.y);
+        xFirst = 0.0;
+        xLast = data.x.last();
+    }
     maxNum = distribution.maxNum;
 }
 
+Amount_t DistributionPlottableBundle::getXFirst() const
+{
+    return xFirst;
+}
+
 Amount_t DistributionPlottableBundle::getXLast() const
 {
     return xLast;
 }
 
+bool DistributionPlottableBundle::isLogScale() const
+{
+    return logScale;
+}
+
 Amount_t DistributionPlottableBundle::getMaxNum() const
 {
     return maxNum;
@@ -10,13 +10,21 @@ public:
     DistributionPlottableBundle(QCustomPlot* plot);
     virtual void removeSelf() override;
     void updateData(HeavyDistribution const& distribution);
+    Amount_t getXFirst() const;
     Amount_t getXLast() const;
     Amount_t getMaxNum() const;
+    bool isLogScale() const;
 
 private:
+    //linear buckets are drawn as bars, log ones of growing width as steps through their edges
     QCPBars* bars;
+    QCPGraph* steps;
+    Amount_t xFirst;
     Amount_t xLast;
     Amount_t maxNum;
+    bool logScale;
+    //reused by updateData
+    ResourceDataPair edges;
 };
 
 #endif // DISTRIBUTIONPLOTTABLEBUNDLE_H
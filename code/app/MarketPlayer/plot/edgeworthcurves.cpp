@@ -0,0 +1,56 @@
+#include "edgeworthcurves.h"
+
+#include <limits>
+
+namespace {
+//about a third of a pixel in a box of a thousand pixels
+Amount_t const tolerance = 1.0 / 3000;
+
+//The q1 where the indifference curve reaches q2Max, left of it the curve is above the box
+Amount_t findCurveStart(IndifferenceCurve const& curve, Amount_t q2Max)
+{
+    Amount_t const exponent = curve.utility.getCurveExponent();
+    Amount_t const start = exponent > 0 ? curve.fixP.q1 * pow(curve.fixP.q2 / q2Max, 1 / exponent) : 0;
+    return std::max(start, std::numeric_limits<Amount_t>::epsilon());
+}
+}
+
+bool EdgeworthCurves::Key::operator==(Key const& other) const
+{
+    return fix1.q1 == other.fix1.q1 && fix1.q2 == other.fix1.q2
+            && fix2.q1 == other.fix2.q1 && fix2.q2 == other.fix2.q2
+            && exponent1 == other.exponent1 && exponent2 == other.exponent2
+            && q1Sum == other.q1Sum && q2Sum == other.q2Sum;
+}
+
+EdgeworthCurves::EdgeworthCurves()
+    : isSampled(false)
+{
+}
+
+void EdgeworthCurves::update(const EdgeworthSituation &situation)
+{
+    IndifferenceCurve const& c1 = situation.curve1;
+    IndifferenceCurve const& c2 = situation.curve2;
+    Amount_t const q1Sum = situation.q1Sum;
+    Amount_t const q2Sum = situation.q2Sum;
+    Key const key{c1.fixP, c2.fixP, c1.utility.getCurveExponent(), c2.utility.getCurveExponent(), q1Sum, q2Sum};
+    if (isSampled && key == sampledKey) {
+        return;
+    }
+
+    Amount_t const curve1Start = std::min(findCurveStart(c1, q2Sum), q1Sum);
+    sampleFunctionAdaptive([&c1](Amount_t q1) { return c1.getQ2(q1); },
+                           curve1Start, q1Sum, q1Sum, q2Sum, tolerance, curve1);
+
+    //curve 2 is drawn from the opposite corner, it leaves the box at the right instead
+    Amount_t const curve2Finish = std::max(q1Sum - findCurveStart(c2, q2Sum), Amount_t(0));
+    sampleFunctionAdaptive([&c2, q1Sum, q2Sum](Amount_t q1) { return q2Sum - c2.getQ2(q1Sum - q1); },
+                           std::numeric_limits<Amount_t>::epsilon(), curve2Finish, q1Sum, q2Sum, tolerance, curve2);
+
+    sampleFunctionAdaptive(situation.getParetoSetFunction(),
+                           std::numeric_limits<Amount_t>::epsilon(), q1Sum, q1Sum, q2Sum, tolerance, paretoSet);
+
+    sampledKey = key;
+    isSampled = true;
+}
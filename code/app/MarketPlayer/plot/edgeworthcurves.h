@@ -0,0 +1,32 @@
+#ifndef EDGEWORTHCURVES_H
+#define EDGEWORTHCURVES_H
+
+#include "model.h"
+
+//The curves of the Edgeworth box sampled adaptively into buffers kept between situations.
+//Only the part inside the box is sampled, so the asymptote of an indifference curve costs a few points
+//instead of thousands. Redrawing the same pair (e.g. after showing the tab) does not sample again.
+struct EdgeworthCurves
+{
+    EdgeworthCurves();
+
+    void update(EdgeworthSituation const& situation);
+
+    ResourceDataPair curve1;
+    ResourceDataPair curve2;
+    ResourceDataPair paretoSet;
+
+private:
+    //what the sampled curves depend on
+    struct Key {
+        Position fix1, fix2;
+        double exponent1, exponent2;
+        Amount_t q1Sum, q2Sum;
+        bool operator==(Key const& other) const;
+    };
+
+    Key sampledKey;
+    bool isSampled;
+};
+
+#endif // EDGEWORTHCURVES_H
@@ -0,0 +1,115 @@
+#include "minmaxpyramid.h"
+
+MinMaxPyramid::MinMaxPyramid()
+    : count(0)
+{
+}
+
+void MinMaxPyramid::clear()
+{
+    levels.clear();
+    count = 0;
+}
+
+void MinMaxPyramid::extend(const DataTimePair &series)
+{
+    while (count < series.size()) {
+        add(series, count);
+        ++count;
+    }
+}
+
+//Level L exists once there are more than 2^L points, its first block then covers all of them
+void MinMaxPyramid::add(const DataTimePair &series, size_t idx)
+{
+    for (size_t level = 0; level < levels.size(); ++level) {
+        auto& blocks = levels[level];
+        size_t const blockIdx = idx >> (level + 1);
+        if (blockIdx == blocks.size()) {
+            blocks.push_back(Block{idx, idx});
+        } else {
+            blocks[blockIdx] = merge(series, blocks[blockIdx], Block{idx, idx});
+        }
+    }
+    bool const isPowerOfTwo = idx > 0 && (idx & (idx - 1)) == 0;
+    if (isPowerOfTwo) {
+        Block const top = levels.empty()
+                ? merge(series, Block{0, 0}, Block{1, 1})
+                : merge(series, levels.back()[0], levels.back()[1]);
+        levels.push_back(std::vector<Block>(1, top));
+    }
+}
+
+MinMaxPyramid::Block MinMaxPyramid::merge(const DataTimePair &series, const Block &a, const Block &b)
+{
+    return Block{
+        series[b.minIdx] < series[a.minIdx] ? b.minIdx : a.minIdx,
+        series[b.maxIdx] > series[a.maxIdx] ? b.maxIdx : a.maxIdx
+    };
+}
+
+MinMaxPyramid::Block MinMaxPyramid::findExtremes(const DataTimePair &series, size_t firstIdx, size_t lastIdx) const
+{
+    Block result{firstIdx, firstIdx};
+    size_t idx = firstIdx;
+    while (idx <= lastIdx) {
+        //the largest block starting at idx and ending within the range, or the point itself
+        size_t level = 0;
+        while (level < levels.size()
+               && idx % (size_t(2) << level) == 0
+               && idx + (size_t(2) << level) - 1 <= lastIdx) {
+            ++level;
+        }
+        if (level == 0) {
+            result = merge(series, result, Block{idx, idx});
+            ++idx;
+        } else {
+            size_t const blockSize = size_t(1) << level;
+            result = merge(series, result, levels[level - 1][idx / blockSize]);
+            idx += blockSize;
+        }
+    }
+    return result;
+}
+
+void MinMaxPyramid::decimate(const DataTimePair &series, size_t firstIdx, size_t lastIdx, size_t numColumns,
+                             ResourceDataPair &result) const
+{
+    result.reset();
+    if (firstIdx > lastIdx || lastIdx >= count) {
+        return;
+    }
+    size_t const numPoints = lastIdx - firstIdx + 1;
+    numColumns = std::max<size_t>(numColumns, 1);
+    if (numPoints <= 2 * numColumns || levels.empty()) {
+        for (size_t idx = firstIdx; idx <= lastIdx; ++idx) {
+            result.push(series.getX(idx), series[idx]);
+        }
+        return;
+    }
+
+    size_t level = 0;
+    while (level + 1 < levels.size() && (numPoints >> (level + 1)) > numColumns) {
+        ++level;
+    }
+    auto const& blocks = levels[level];
+    selectedIdxs.clear();
+    selectedIdxs.push_back(firstIdx);
+    size_t const blockSize = size_t(1) << (level + 1);
+    for (size_t blockIdx = firstIdx / blockSize; blockIdx <= lastIdx / blockSize; ++blockIdx) {
+        size_t const blockFirstIdx = blockIdx * blockSize;
+        size_t const blockLastIdx = blockFirstIdx + blockSize - 1;
+        //the boundary blocks are clipped to the range
+        Block const block = blockFirstIdx >= firstIdx && blockLastIdx <= lastIdx
+                ? blocks[blockIdx]
+                : findExtremes(series, std::max(blockFirstIdx, firstIdx), std::min(blockLastIdx, lastIdx));
+        selectedIdxs.push_back(std::min(block.minIdx, block.maxIdx));
+        selectedIdxs.push_back(std::max(block.minIdx, block.maxIdx));
+    }
+    selectedIdxs.push_back(lastIdx);
+    std::sort(selectedIdxs.begin(), selectedIdxs.end());
+    selectedIdxs.erase(std::unique(selectedIdxs.begin(), selectedIdxs.end()), selectedIdxs.end());
+    for (auto idx : selectedIdxs) {
+        result.push(series.getX(idx), series[idx]);
+    }
+}
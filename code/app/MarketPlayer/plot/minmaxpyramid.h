@@ -0,0 +1,45 @@
+#ifndef MINMAXPYRAMID_H
+#define MINMAXPYRAMID_H
+
+#include <vector>
+#include <cstddef>
+
+#include "modelutils.h"
+
+//Level of detail of a time series for drawing. Level L splits the points into blocks of 2^(L+1)
+//and keeps the index of the lowest and the highest value of each block, so any index range can be drawn
+//by about two points per pixel column without losing the spikes.
+//It grows with the series, a point costs O(log points).
+struct MinMaxPyramid
+{
+    MinMaxPyramid();
+
+    void clear();
+    //Summarises the points of the series beyond the ones already seen.
+    //The caller rebuilds (clear, extend) when the seen points changed, e.g. after thinning.
+    void extend(DataTimePair const& series);
+    size_t size() const { return count; }
+
+    //The points of [firstIdx, lastIdx] for numColumns pixel columns in time order: all of them if they fit
+    //two to a column, otherwise the extremes of the blocks of the finest level that fits, plus both ends.
+    void decimate(DataTimePair const& series, size_t firstIdx, size_t lastIdx, size_t numColumns,
+                  ResourceDataPair& result) const;
+
+private:
+    struct Block {
+        size_t minIdx;
+        size_t maxIdx;
+    };
+
+    void add(DataTimePair const& series, size_t idx);
+    //extremes of [firstIdx, lastIdx] from the largest aligned blocks covering it, O(log points)
+    Block findExtremes(DataTimePair const& series, size_t firstIdx, size_t lastIdx) const;
+    static Block merge(DataTimePair const& series, Block const& a, Block const& b);
+
+    std::vector<std::vector<Block>> levels;
+    size_t count;
+    //reused by decimate
+    mutable std::vector<size_t> selectedIdxs;
+};
+
+#endif // MINMAXPYRAMID_H
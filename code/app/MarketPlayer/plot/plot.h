@@ -11,6 +11,7 @@ public:
     Plot(QCustomPlot* plot);
     virtual ~Plot() {}
     virtual void clearData();
+    QCustomPlot* getCustomPlot() const { return plot; }
 };
 
 #endif // PLOT_H
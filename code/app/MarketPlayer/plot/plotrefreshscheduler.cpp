@@ -0,0 +1,92 @@
+#include "plotrefreshscheduler.h"
+
+#include <QWidget>
+#include <QTimer>
+#include <QEvent>
+#include <algorithm>
+
+PlotRefreshScheduler::PlotRefreshScheduler(QObject *parent)
+    :   QObject(parent),
+      frameTimer(new QTimer(this)),
+      maxFramesPerSecond(defaultMaxFramesPerSecond),
+      refreshNanoseconds(0)
+{
+    frameTimer->setSingleShot(true);
+    connect(frameTimer, SIGNAL(timeout()),
+            this, SLOT(onFrame()));
+}
+
+void PlotRefreshScheduler::addPlot(QWidget *widget, Refresh refresh)
+{
+    entries.push_back(Entry{widget, refresh, false});
+    widget->installEventFilter(this);
+}
+
+void PlotRefreshScheduler::markDirty(QWidget *widget)
+{
+    for (auto& entry : entries) {
+        if (entry.widget == widget) {
+            entry.isDirty = true;
+        }
+    }
+    scheduleFrame();
+}
+
+void PlotRefreshScheduler::setMaxFramesPerSecond(int maxFramesPerSecond)
+{
+    this->maxFramesPerSecond = std::max(1, maxFramesPerSecond);
+}
+
+int PlotRefreshScheduler::getMaxFramesPerSecond() const
+{
+    return maxFramesPerSecond;
+}
+
+qint64 PlotRefreshScheduler::takeRefreshNanoseconds()
+{
+    qint64 const result = refreshNanoseconds;
+    refreshNanoseconds = 0;
+    return result;
+}
+
+bool PlotRefreshScheduler::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Show) {
+        scheduleFrame();
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void PlotRefreshScheduler::onFrame()
+{
+    sinceLastFrame.start();
+    //a refresh may mark others dirty, those wait for the next frame
+    for (size_t entryIdx = 0; entryIdx < entries.size(); ++entryIdx) {
+        if (entries[entryIdx].isDirty && entries[entryIdx].widget->isVisible()) {
+            entries[entryIdx].isDirty = false;
+            entries[entryIdx].refresh();
+        }
+    }
+    refreshNanoseconds += sinceLastFrame.nsecsElapsed();
+}
+
+//Waits out the rest of the frame since the last refresh, changes arriving meanwhile share the frame
+void PlotRefreshScheduler::scheduleFrame()
+{
+    if (frameTimer->isActive() || !hasVisibleDirtyPlot()) {
+        return;
+    }
+    int delay = 0;
+    if (sinceLastFrame.isValid()) {
+        int const frameMilliseconds = 1000 / maxFramesPerSecond;
+        delay = std::max(0, frameMilliseconds - static_cast<int>(sinceLastFrame.elapsed()));
+    }
+    frameTimer->start(delay);
+}
+
+bool PlotRefreshScheduler::hasVisibleDirtyPlot() const
+{
+    return std::any_of(entries.begin(), entries.end(), [](Entry const& entry) {
+        return entry.isDirty && entry.widget->isVisible();
+    });
+}
@@ -0,0 +1,57 @@
+#ifndef PLOTREFRESHSCHEDULER_H
+#define PLOTREFRESHSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <functional>
+#include <vector>
+
+class QWidget;
+class QTimer;
+
+//Repaints the plots at most maxFramesPerSecond times a second.
+//A change only marks its plot dirty, the refresh runs on the next frame and only while the plot is visible.
+//A plot on a hidden tab is skipped and catches up when it is shown.
+class PlotRefreshScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void()> Refresh;
+    static const int defaultMaxFramesPerSecond = 30;
+
+    explicit PlotRefreshScheduler(QObject* parent = 0);
+
+    //refresh pushes the data into the plot and replots it, it runs first when the plot is marked dirty
+    void addPlot(QWidget* widget, Refresh refresh);
+    void markDirty(QWidget* widget);
+    void setMaxFramesPerSecond(int maxFramesPerSecond);
+    int getMaxFramesPerSecond() const;
+    //time spent in refreshes since the last call
+    qint64 takeRefreshNanoseconds();
+
+protected:
+    virtual bool eventFilter(QObject* watched, QEvent* event) override;
+
+private slots:
+    void onFrame();
+
+private:
+    struct Entry {
+        QWidget* widget;
+        Refresh refresh;
+        bool isDirty;
+    };
+
+    void scheduleFrame();
+    bool hasVisibleDirtyPlot() const;
+
+    std::vector<Entry> entries;
+    //owned by the scheduler
+    QTimer* frameTimer;
+    QElapsedTimer sinceLastFrame;
+    int maxFramesPerSecond;
+    qint64 refreshNanoseconds;
+};
+
+#endif // PLOTREFRESHSCHEDULER_H
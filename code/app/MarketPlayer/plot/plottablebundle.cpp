@@ -46,5 +46,10 @@ void PlottableBundle::applyColor(PlottableInfo& info)
         auto currentPen = info.first->pen();
         currentPen.setColor(color);
         info.first->setPen(currentPen);
+    } else if (info.second == DynamicFill) {
+        QColor fillColor = color;
+        fillColor.setAlpha(50);
+        info.first->setPen(Qt::NoPen);
+        info.first->setBrush(fillColor);
     }
 }
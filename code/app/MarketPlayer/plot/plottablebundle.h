@@ -9,7 +9,9 @@ struct PlottableBundle
 {
     enum ColorStrategy {
         FixColor,
-        DynamicColor
+        DynamicColor,
+        //the fill takes a translucent variant of the color, the line is not drawn
+        DynamicFill
     };
 
     PlottableBundle(QCustomPlot* plot);
@@ -14554,6 +14554,7 @@ void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
+  mData->reserve(n);
   QCPData newData;
   for (int i=0; i<n; ++i)
   {
@@ -14931,9 +14932,7 @@ void QCPGraph::addData(const QVector<double> &keys, const QVector<double> &value
 */
 void QCPGraph::removeDataBefore(double key)
 {
-  QCPDataMap::iterator it = mData->begin();
-  while (it != mData->end() && it.key() < key)
-    it = mData->erase(it);
+  mData->erase(mData->begin(), mData->lowerBound(key));
 }
 
 /*!
@@ -14942,10 +14941,7 @@ void QCPGraph::removeDataBefore(double key)
 */
 void QCPGraph::removeDataAfter(double key)
 {
-  if (mData->isEmpty()) return;
-  QCPDataMap::iterator it = mData->upperBound(key);
-  while (it != mData->end())
-    it = mData->erase(it);
+  mData->erase(mData->upperBound(key), mData->end());
 }
 
 /*!
@@ -14958,10 +14954,7 @@ void QCPGraph::removeDataAfter(double key)
 void QCPGraph::removeData(double fromKey, double toKey)
 {
   if (fromKey >= toKey || mData->isEmpty()) return;
-  QCPDataMap::iterator it = mData->upperBound(fromKey);
-  QCPDataMap::iterator itEnd = mData->upperBound(toKey);
-  while (it != itEnd)
-    it = mData->erase(it);
+  mData->erase(mData->upperBound(fromKey), mData->upperBound(toKey));
 }
 
 /*! \overload
@@ -15969,14 +15962,8 @@ int QCPGraph::countDataInBounds(const QCPDataMap::const_iterator &lower, const Q
 {
   if (upper == mData->constEnd() && lower == mData->constEnd())
     return 0;
-  QCPDataMap::const_iterator it = lower;
-  int count = 1;
-  while (it != upper && count < maxCount)
-  {
-    ++it;
-    ++count;
-  }
-  return count;
+  // the data is contiguous, so this is a subtraction instead of a walk
+  return qMin(maxCount, int(upper-lower)+1);
 }
 
 /*! \internal
@@ -17541,6 +17528,7 @@ void QCPBars::setData(const QVector<double> &key, const QVector<double> &value)
   mData->clear();
   int n = key.size();
   n = qMin(n, value.size());
+  mData->reserve(n);
   QCPBarData newData;
   for (int i=0; i<n; ++i)
   {
@@ -17669,9 +17657,7 @@ void QCPBars::addData(const QVector<double> &keys, const QVector<double> &values
 */
 void QCPBars::removeDataBefore(double key)
 {
-  QCPBarDataMap::iterator it = mData->begin();
-  while (it != mData->end() && it.key() < key)
-    it = mData->erase(it);
+  mData->erase(mData->begin(), mData->lowerBound(key));
 }
 
 /*!
@@ -17680,10 +17666,7 @@ void QCPBars::removeDataBefore(double key)
 */
 void QCPBars::removeDataAfter(double key)
 {
-  if (mData->isEmpty()) return;
-  QCPBarDataMap::iterator it = mData->upperBound(key);
-  while (it != mData->end())
-    it = mData->erase(it);
+  mData->erase(mData->upperBound(key), mData->end());
 }
 
 /*!
@@ -17696,10 +17679,7 @@ void QCPBars::removeDataAfter(double key)
 void QCPBars::removeData(double fromKey, double toKey)
 {
   if (fromKey >= toKey || mData->isEmpty()) return;
-  QCPBarDataMap::iterator it = mData->upperBound(fromKey);
-  QCPBarDataMap::iterator itEnd = mData->upperBound(toKey);
-  while (it != itEnd)
-    it = mData->erase(it);
+  mData->erase(mData->upperBound(fromKey), mData->upperBound(toKey));
 }
 
 /*! \overload
@@ -17755,12 +17735,11 @@ void QCPBars::draw(QCPPainter *painter)
   if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
   if (mData->isEmpty()) return;
   
-  QCPBarDataMap::const_iterator it;
-  for (it = mData->constBegin(); it != mData->constEnd(); ++it)
+  // only the bars reaching into the key axis range are visited:
+  QCPBarDataMap::const_iterator it = mData->lowerBound(mKeyAxis.data()->range().lower-mWidth*0.5);
+  QCPBarDataMap::const_iterator itEnd = mData->upperBound(mKeyAxis.data()->range().upper+mWidth*0.5);
+  for (; it != itEnd; ++it)
   {
-    // skip bar if not visible in key axis range:
-    if (it.key()+mWidth*0.5 < mKeyAxis.data()->range().lower || it.key()-mWidth*0.5 > mKeyAxis.data()->range().upper)
-      continue;
     // check data validity if flag set:
 #ifdef QCUSTOMPLOT_CHECK_DATA
     if (QCP::isInvalidData(it.value().key, it.value().value))
@@ -45,6 +45,9 @@
 #include <QMargins>
 #include <qmath.h>
 #include <limits>
+#include <vector>
+#include <algorithm>
+#include <iterator>
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
 #  include <qnumeric.h>
 #  include <QPrinter>
@@ -2436,6 +2439,159 @@ private:
 };
 
 
+/*! \class QCPSortedData
+  \brief Container for data points kept sorted by their key member, stored contiguously
+
+  It provides the part of the QMap interface that QCustomPlot uses (iterators with key() and
+  value(), lowerBound, upperBound, insertMulti, unite, erase, remove), but holds the points in one
+  vector instead of one heap node per point. Appending in key order, the usual case, costs
+  amortized constant time, and drawing walks the memory linearly. Inserting before the last key
+  shifts the following points. Iterators are random access and invalidated by any modification.
+
+  \see QCPDataMap, QCPBarDataMap
+*/
+template <class DataType>
+class QCPSortedData
+{
+public:
+  class const_iterator;
+  
+  class iterator
+  {
+  public:
+    iterator() : mPtr(0) {}
+    explicit iterator(DataType *ptr) : mPtr(ptr) {}
+    double key() const { return mPtr->key; }
+    DataType &value() const { return *mPtr; }
+    DataType &operator*() const { return *mPtr; }
+    DataType *operator->() const { return mPtr; }
+    iterator &operator++() { ++mPtr; return *this; }
+    iterator operator++(int) { iterator result(*this); ++mPtr; return result; }
+    iterator &operator--() { --mPtr; return *this; }
+    iterator operator--(int) { iterator result(*this); --mPtr; return result; }
+    iterator &operator+=(int n) { mPtr += n; return *this; }
+    iterator &operator-=(int n) { mPtr -= n; return *this; }
+    iterator operator+(int n) const { return iterator(mPtr+n); }
+    iterator operator-(int n) const { return iterator(mPtr-n); }
+    int operator-(const iterator &other) const { return int(mPtr-other.mPtr); }
+    bool operator==(const iterator &other) const { return mPtr == other.mPtr; }
+    bool operator!=(const iterator &other) const { return mPtr != other.mPtr; }
+  private:
+    DataType *mPtr;
+    friend class const_iterator;
+    friend class QCPSortedData;
+  };
+  
+  class const_iterator
+  {
+  public:
+    const_iterator() : mPtr(0) {}
+    explicit const_iterator(const DataType *ptr) : mPtr(ptr) {}
+    const_iterator(const iterator &other) : mPtr(other.mPtr) {}
+    double key() const { return mPtr->key; }
+    const DataType &value() const { return *mPtr; }
+    const DataType &operator*() const { return *mPtr; }
+    const DataType *operator->() const { return mPtr; }
+    const_iterator &operator++() { ++mPtr; return *this; }
+    const_iterator operator++(int) { const_iterator result(*this); ++mPtr; return result; }
+    const_iterator &operator--() { --mPtr; return *this; }
+    const_iterator operator--(int) { const_iterator result(*this); --mPtr; return result; }
+    const_iterator &operator+=(int n) { mPtr += n; return *this; }
+    const_iterator &operator-=(int n) { mPtr -= n; return *this; }
+    const_iterator operator+(int n) const { return const_iterator(mPtr+n); }
+    const_iterator operator-(int n) const { return const_iterator(mPtr-n); }
+    friend int operator-(const const_iterator &a, const const_iterator &b) { return int(a.mPtr-b.mPtr); }
+    friend bool operator==(const const_iterator &a, const const_iterator &b) { return a.mPtr == b.mPtr; }
+    friend bool operator!=(const const_iterator &a, const const_iterator &b) { return a.mPtr != b.mPtr; }
+  private:
+    const DataType *mPtr;
+  };
+  
+  typedef iterator Iterator;
+  typedef const_iterator ConstIterator;
+  
+  bool isEmpty() const { return mData.empty(); }
+  int size() const { return int(mData.size()); }
+  int count() const { return size(); }
+  void clear() { mData.clear(); }
+  void reserve(int size) { mData.reserve(size); }
+  
+  iterator begin() { return iterator(mData.data()); }
+  iterator end() { return iterator(mData.data()+mData.size()); }
+  const_iterator begin() const { return constBegin(); }
+  const_iterator end() const { return constEnd(); }
+  const_iterator constBegin() const { return const_iterator(mData.data()); }
+  const_iterator constEnd() const { return const_iterator(mData.data()+mData.size()); }
+  
+  iterator lowerBound(double key) { return begin()+lowerBoundIndex(key); }
+  const_iterator lowerBound(double key) const { return constBegin()+lowerBoundIndex(key); }
+  iterator upperBound(double key) { return begin()+upperBoundIndex(key); }
+  const_iterator upperBound(double key) const { return constBegin()+upperBoundIndex(key); }
+  
+  /*!
+    Inserts \a data after the points with the same key. \a key has to be the key of \a data, it is
+    only taken for compatibility with QMap.
+  */
+  iterator insertMulti(double key, const DataType &data)
+  {
+    if (mData.empty() || !(key < mData.back().key))
+    {
+      mData.push_back(data);
+      return end()-1;
+    }
+    int index = upperBoundIndex(key);
+    mData.insert(mData.begin()+index, data);
+    return begin()+index;
+  }
+  
+  /*!
+    Adds the points of \a other, merging the two sorted sequences in linear time.
+  */
+  void unite(const QCPSortedData &other)
+  {
+    std::vector<DataType> merged;
+    merged.reserve(mData.size()+other.mData.size());
+    std::merge(mData.begin(), mData.end(), other.mData.begin(), other.mData.end(), std::back_inserter(merged), &QCPSortedData::dataLess);
+    mData.swap(merged);
+  }
+  
+  iterator erase(iterator it) { return erase(it, it+1); }
+  iterator erase(iterator first, iterator last)
+  {
+    int index = first-begin();
+    mData.erase(mData.begin()+index, mData.begin()+(last-begin()));
+    return begin()+index;
+  }
+  
+  /*!
+    Removes the points with key \a key and returns how many there were.
+  */
+  int remove(double key)
+  {
+    iterator first = lowerBound(key);
+    iterator last = upperBound(key);
+    int removed = last-first;
+    erase(first, last);
+    return removed;
+  }
+  
+private:
+  std::vector<DataType> mData;
+  
+  static bool dataLess(const DataType &a, const DataType &b) { return a.key < b.key; }
+  static bool dataLessThanKey(const DataType &data, double key) { return data.key < key; }
+  static bool keyLessThanData(double key, const DataType &data) { return key < data.key; }
+  int lowerBoundIndex(double key) const
+  {
+    return int(std::lower_bound(mData.begin(), mData.end(), key, &QCPSortedData::dataLessThanKey)-mData.begin());
+  }
+  int upperBoundIndex(double key) const
+  {
+    return int(std::upper_bound(mData.begin(), mData.end(), key, &QCPSortedData::keyLessThanData)-mData.begin());
+  }
+};
+
+
 /*! \file */
 
 
@@ -2453,14 +2609,12 @@ Q_DECLARE_TYPEINFO(QCPData, Q_MOVABLE_TYPE);
 
 /*! \typedef QCPDataMap
   Container for storing QCPData items in a sorted fashion. The key of the map
-  is the key member of the QCPData instance.
+  is the key member of the QCPData instance. The items are stored contiguously, see QCPSortedData.
   
   This is the container in which QCPGraph holds its data.
   \see QCPData, QCPGraph::setData
 */
-typedef QMap<double, QCPData> QCPDataMap;
-typedef QMapIterator<double, QCPData> QCPDataMapIterator;
-typedef QMutableMapIterator<double, QCPData> QCPDataMutableMapIterator;
+typedef QCPSortedData<QCPData> QCPDataMap;
 
 
 class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable
@@ -2719,14 +2873,12 @@ Q_DECLARE_TYPEINFO(QCPBarData, Q_MOVABLE_TYPE);
 
 /*! \typedef QCPBarDataMap
   Container for storing QCPBarData items in a sorted fashion. The key of the map
-  is the key member of the QCPBarData instance.
+  is the key member of the QCPBarData instance. The items are stored contiguously, see QCPSortedData.
   
   This is the container in which QCPBars holds its data.
   \see QCPBarData, QCPBars::setData
 */
-typedef QMap<double, QCPBarData> QCPBarDataMap;
-typedef QMapIterator<double, QCPBarData> QCPBarDataMapIterator;
-typedef QMutableMapIterator<double, QCPBarData> QCPBarDataMutableMapIterator;
+typedef QCPSortedData<QCPBarData> QCPBarDataMap;
 
 
 class QCP_LIB_DECL QCPBars : public QCPAbstractPlottable
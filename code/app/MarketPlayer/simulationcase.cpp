@@ -7,22 +7,22 @@ AbstractSimulationCase::AbstractSimulationCase(QString caseName, QColor color, b
 {
 }
 
-HeavySimulationCase::HeavySimulationCase(const Simulation &simulation, QString caseName, QColor color, bool visible)
+HeavySimulationCase::HeavySimulationCase(const SimulationSnapshot &snapshot, QString caseName, QColor color, bool visible)
     :   AbstractSimulationCase(caseName, color, visible)
-    ,   simulation(simulation)
+    ,   snapshot(snapshot)
 {
 }
 
 const Simulation &HeavySimulationCase::getSimulation() const {
-    return simulation;
+    return *snapshot;
 }
 
-ExternalSimulationCase::ExternalSimulationCase(const Simulation &simulation, QString caseName, QColor color, bool visible)
+ExternalSimulationCase::ExternalSimulationCase(const SimulationSnapshot &simulation, QString caseName, QColor color, bool visible)
     :   AbstractSimulationCase(caseName, color, visible)
     ,   simulation(&simulation)
 {
 }
 
 const Simulation &ExternalSimulationCase::getSimulation() const {
-    return *simulation;
+    return **simulation;
 }
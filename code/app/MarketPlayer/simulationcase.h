@@ -15,22 +15,24 @@ struct AbstractSimulationCase
     bool isShown;    
 };
 
+//Holds a snapshot, which shares the actors and the finished rounds with the simulation it was taken of
 struct HeavySimulationCase : AbstractSimulationCase
 {
-    HeavySimulationCase(Simulation const& simulation, QString caseName, QColor color, bool visible);
+    HeavySimulationCase(SimulationSnapshot const& snapshot, QString caseName, QColor color, bool visible);
     virtual Simulation const& getSimulation() const;
 
 private:
-    Simulation simulation;
+    SimulationSnapshot snapshot;
 };
 
+//Shows whichever snapshot the pointer is set to at the time
 struct ExternalSimulationCase : AbstractSimulationCase
 {
-    ExternalSimulationCase(Simulation const& simulation, QString caseName, QColor color, bool visible);
+    ExternalSimulationCase(SimulationSnapshot const& simulation, QString caseName, QColor color, bool visible);
     virtual Simulation const& getSimulation() const;
 
 private:
-    Simulation const* simulation;
+    SimulationSnapshot const* simulation;
 };
 
 #endif // SIMULATIONCASE_H
@@ -0,0 +1,217 @@
+#include "simulationconfig.h"
+#include "strategymapper.h"
+
+#include <QSettings>
+#include <QFileInfo>
+
+QString appGroupKey = "application";
+QString configVersionKey = "config_version";
+QString currentConfigVersion = "1.6";
+
+//since 1.0
+QString simulationGroupKey = "simulation";
+QString q1SumKey = "q1_sum";
+QString q2SumKey = "q2_sum";
+QString numActorsKey = "num_actors";
+QString randomSeedKey = "random_seed";
+
+QString offerStrategyKey = "offer_strategy";
+QString acceptanceStrategyKey = "acceptance_strategy";
+
+//since 1.1
+QString minTradeFactorKey = "min_trade_factor";
+QString maxRoundWithoutTradeKey = "max_round_without_trade";
+
+//since 1.2
+QString numThreadsKey = "num_threads";
+
+//since 1.3
+QString historyRecentRoundsKey = "history_recent_rounds";
+
+//since 1.4
+QString stoppingGroupKey = "stopping";
+QString utilityWindowKey = "utility_window";
+QString utilityEpsilonKey = "utility_epsilon";
+QString volumeWindowKey = "volume_window";
+QString volumeThresholdKey = "volume_threshold";
+QString maxRoundsKey = "max_rounds";
+QString maxSecondsKey = "max_seconds";
+QString combineKey = "combine";
+QString combineAllValue = "all";
+QString combineAnyValue = "any";
+
+//since 1.5
+QString histogramScaleKey = "histogram_scale";
+QString histogramMaxBucketsKey = "histogram_max_buckets";
+QString linearScaleValue = "linear";
+QString logScaleValue = "log";
+
+//since 1.6
+QString numGoodsKey = "num_goods";
+//q3_sum, q4_sum, ...
+QString goodSumKeyPattern = "q%1_sum";
+
+SimulationConfig::SimulationConfig()
+    : seed(0)
+    , numActors(0)
+    , amountQ1(0)
+    , amountQ2(0)
+    , numGoods(2)
+    , alfa1(defaultAlfa1)
+    , alfa2(defaultAlfa2)
+    , minTradeFactor(defaultMinTradeFactor)
+    , maxRoundWithoutTrade(defaultMaxRoundWithoutTrade)
+    , numThreads(0)
+    , historyRecentRounds(0)
+{
+}
+
+SimulationConfig configFromSimulation(const Simulation &simulation)
+{
+    SimulationConfig config;
+    config.seed = simulation.seed;
+    config.numActors = simulation.numActors;
+    config.amountQ1 = simulation.amounts[0];
+    config.amountQ2 = simulation.amounts[1];
+    config.alfa1 = simulation.utility.getAlfa1();
+    config.alfa2 = simulation.utility.getAlfa2();
+    config.minTradeFactor = simulation.minTradeFactor;
+    config.maxRoundWithoutTrade = simulation.maxRoundWithoutTrade;
+    OfferStrategyNameVisitor ov;
+    config.offerStrategy = ov.getStrategyDescription(*simulation.offerStrategy);
+    AcceptanceStrategyNameVisitor av;
+    config.acceptanceStrategy = av.getStrategyDescription(*simulation.acceptanceStrategy);
+    config.numThreads = simulation.numThreads;
+    RetentionPolicy const& retentionPolicy = simulation.history.getRetentionPolicy();
+    config.historyRecentRounds = retentionPolicy.keepsAll() ? 0 : retentionPolicy.numRecentRounds;
+    config.stopping = simulation.getStoppingCriteria();
+    config.histogram = simulation.getHistogramSettings();
+    return config;
+}
+
+bool setupSimulationByConfig(Simulation &simulation, const SimulationConfig &config)
+{
+    if (config.numGoods != 2) {
+        return false;
+    }
+    simulation.history.setRetentionPolicy(config.historyRecentRounds > 0 ?
+                                              RetentionPolicy::tiered(config.historyRecentRounds) :
+                                              RetentionPolicy::keepAll());
+    simulation.setStoppingCriteria(config.stopping);
+    simulation.setHistogramSettings(config.histogram);
+    bool success = simulation.setup(config.seed, config.numActors, config.amountQ1, config.amountQ2,
+                                    config.alfa1, config.alfa2, config.minTradeFactor, config.maxRoundWithoutTrade);
+    if (success) {
+        simulation.setStrategies(createOfferStrategy(config.offerStrategy),
+                                 createAcceptanceStrategy(config.acceptanceStrategy));
+        simulation.setNumThreads(config.numThreads);
+        success = simulation.offerStrategy.get() && simulation.acceptanceStrategy.get();
+    }
+    return success;
+}
+
+bool loadSimulationConfig(QString fileName, SimulationConfig &config)
+{
+    if (!QFileInfo(fileName).isReadable()) {
+        return false;
+    }
+    QSettings settings(fileName, QSettings::IniFormat);
+    settings.beginGroup(appGroupKey);
+    QString fileConfigVersion = settings.value(configVersionKey).toString();
+    settings.endGroup();
+
+    settings.beginGroup(simulationGroupKey);
+
+    config.amountQ1 = settings.value(q1SumKey).toUInt();
+    config.amountQ2 = settings.value(q2SumKey).toUInt();
+    config.numActors = settings.value(numActorsKey).toUInt();
+    config.seed = settings.value(randomSeedKey).toUInt();
+    config.alfa1 = SimulationConfig::defaultAlfa1;
+    config.alfa2 = SimulationConfig::defaultAlfa2;
+
+    config.minTradeFactor = SimulationConfig::defaultMinTradeFactor;
+    config.maxRoundWithoutTrade = SimulationConfig::defaultMaxRoundWithoutTrade;
+    if (fileConfigVersion >= "1.1") {
+        config.minTradeFactor = settings.value(minTradeFactorKey).toDouble();
+        config.maxRoundWithoutTrade = settings.value(maxRoundWithoutTradeKey).toUInt();
+    }
+    config.numThreads = 0;
+    if (fileConfigVersion >= "1.2") {
+        config.numThreads = settings.value(numThreadsKey).toUInt();
+    }
+    config.historyRecentRounds = 0;
+    if (fileConfigVersion >= "1.3") {
+        config.historyRecentRounds = settings.value(historyRecentRoundsKey).toUInt();
+    }
+    config.numGoods = 2;
+    config.furtherAmounts.clear();
+    if (fileConfigVersion >= "1.6") {
+        config.numGoods = settings.value(numGoodsKey, 2).toUInt();
+        for (size_t goodIdx = 2; goodIdx < config.numGoods; ++goodIdx) {
+            config.furtherAmounts.push_back(settings.value(goodSumKeyPattern.arg(goodIdx + 1)).toUInt());
+        }
+    }
+    config.histogram = HistogramSettings();
+    if (fileConfigVersion >= "1.5") {
+        config.histogram.scale = settings.value(histogramScaleKey).toString() == logScaleValue ?
+                    HistogramLayout::LogScale : HistogramLayout::LinearScale;
+        size_t const maxBuckets = settings.value(histogramMaxBucketsKey).toUInt();
+        config.histogram.maxBuckets = maxBuckets > 0 ? maxBuckets : HistogramSettings::defaultMaxBuckets;
+    }
+
+    config.offerStrategy = settings.value(offerStrategyKey).toString();
+    config.acceptanceStrategy = settings.value(acceptanceStrategyKey).toString();
+    settings.endGroup();
+
+    config.stopping = StoppingCriteria();
+    if (fileConfigVersion >= "1.4") {
+        settings.beginGroup(stoppingGroupKey);
+        config.stopping.utilityWindow = settings.value(utilityWindowKey).toUInt();
+        config.stopping.utilityEpsilon = settings.value(utilityEpsilonKey).toDouble();
+        config.stopping.volumeWindow = settings.value(volumeWindowKey).toUInt();
+        config.stopping.volumeThreshold = settings.value(volumeThresholdKey).toDouble();
+        config.stopping.maxRounds = settings.value(maxRoundsKey).toUInt();
+        config.stopping.maxSeconds = settings.value(maxSecondsKey).toDouble();
+        config.stopping.requireAllConvergence = settings.value(combineKey).toString() == combineAllValue;
+        settings.endGroup();
+    }
+    return true;
+}
+
+void saveSimulationConfig(QString fileName, const SimulationConfig &config)
+{
+    QSettings settings(fileName, QSettings::IniFormat);
+    settings.beginGroup(appGroupKey);
+    settings.setValue(configVersionKey, currentConfigVersion);
+    settings.endGroup();
+
+    settings.beginGroup(simulationGroupKey);
+    settings.setValue(q1SumKey, QString::number(config.amountQ1));
+    settings.setValue(q2SumKey, QString::number(config.amountQ2));
+    settings.setValue(numGoodsKey, QString::number(config.numGoods));
+    for (size_t idx = 0; idx < config.furtherAmounts.size(); ++idx) {
+        settings.setValue(goodSumKeyPattern.arg(idx + 3), QString::number(config.furtherAmounts[idx]));
+    }
+    settings.setValue(numActorsKey, QString::number(config.numActors));
+    settings.setValue(randomSeedKey, QString::number(config.seed));
+    settings.setValue(minTradeFactorKey, QString::number(config.minTradeFactor));
+    settings.setValue(maxRoundWithoutTradeKey, QString::number(config.maxRoundWithoutTrade));
+    settings.setValue(offerStrategyKey, config.offerStrategy);
+    settings.setValue(acceptanceStrategyKey, config.acceptanceStrategy);
+    settings.setValue(numThreadsKey, QString::number(config.numThreads));
+    settings.setValue(historyRecentRoundsKey, QString::number(config.historyRecentRounds));
+    settings.setValue(histogramScaleKey, config.histogram.scale == HistogramLayout::LogScale ?
+                          logScaleValue : linearScaleValue);
+    settings.setValue(histogramMaxBucketsKey, QString::number(config.histogram.maxBuckets));
+    settings.endGroup();
+
+    settings.beginGroup(stoppingGroupKey);
+    settings.setValue(utilityWindowKey, QString::number(config.stopping.utilityWindow));
+    settings.setValue(utilityEpsilonKey, QString::number(config.stopping.utilityEpsilon));
+    settings.setValue(volumeWindowKey, QString::number(config.stopping.volumeWindow));
+    settings.setValue(volumeThresholdKey, QString::number(config.stopping.volumeThreshold));
+    settings.setValue(maxRoundsKey, QString::number(config.stopping.maxRounds));
+    settings.setValue(maxSecondsKey, QString::number(config.stopping.maxSeconds));
+    settings.setValue(combineKey, config.stopping.requireAllConvergence ? combineAllValue : combineAnyValue);
+    settings.endGroup();
+}
@@ -0,0 +1,44 @@
+#ifndef SIMULATIONCONFIG_H
+#define SIMULATIONCONFIG_H
+
+#include <QString>
+#include <vector>
+
+#include "model.h"
+
+struct SimulationConfig
+{
+    URNG::result_type seed;
+    size_t numActors;
+    unsigned amountQ1, amountQ2;
+    //More than two goods are traded by GoodsEconomy, only the command line runner does that.
+    //furtherAmounts holds the sums of the goods from the third on.
+    size_t numGoods;
+    std::vector<unsigned> furtherAmounts;
+    double alfa1, alfa2;
+    double minTradeFactor;
+    size_t maxRoundWithoutTrade;
+    QString offerStrategy;
+    QString acceptanceStrategy;
+    size_t numThreads;
+    //0: the history keeps every round, otherwise RetentionPolicy::tiered
+    size_t historyRecentRounds;
+    StoppingCriteria stopping;
+    HistogramSettings histogram;
+
+    SimulationConfig();
+
+    static constexpr double defaultAlfa1 = 0.5;
+    static constexpr double defaultAlfa2 = 0.5;
+
+    static constexpr double defaultMinTradeFactor = 0.01;
+    static const size_t defaultMaxRoundWithoutTrade = 2;
+};
+
+SimulationConfig configFromSimulation(Simulation const& simulation);
+bool setupSimulationByConfig(Simulation& simulation, SimulationConfig const& config);
+
+bool loadSimulationConfig(QString fileName, SimulationConfig& config);
+void saveSimulationConfig(QString fileName, SimulationConfig const& config);
+
+#endif // SIMULATIONCONFIG_H
@@ -0,0 +1,106 @@
+#include "simulationworker.h"
+
+#include <QTimer>
+
+SimulationWorker::SimulationWorker(QObject *parent)
+    :   QObject(parent),
+      generation(0),
+      publishedProgressOnly(false),
+      timer(new QTimer(this)),
+      mailbox(nullptr)
+{
+    connect(timer, SIGNAL(timeout()),
+            this, SLOT(onTimeout()));
+}
+
+SimulationWorker::~SimulationWorker()
+{
+    delete mailbox.exchange(nullptr);
+}
+
+std::unique_ptr<PublishedSimulation> SimulationWorker::takePublished()
+{
+    return std::unique_ptr<PublishedSimulation>(mailbox.exchange(nullptr));
+}
+
+void SimulationWorker::load(SimulationSnapshot simulation, quint64 generation)
+{
+    timer->stop();
+    this->simulation = *simulation;
+    this->generation = generation;
+    publishedProgressOnly = false;
+}
+
+void SimulationWorker::start(int interval)
+{
+    timer->setInterval(interval);
+    timer->start();
+}
+
+void SimulationWorker::pause()
+{
+    timer->stop();
+    if (publishedProgressOnly) {
+        publish(WholeSnapshot);
+    }
+}
+
+void SimulationWorker::setInterval(int interval)
+{
+    timer->setInterval(interval);
+}
+
+void SimulationWorker::performNextRound()
+{
+    if (simulation.canContinueSimulation()) {
+        simulation.performNextRound();
+        publish(WholeSnapshot);
+    }
+}
+
+void SimulationWorker::performNextTrade()
+{
+    if (simulation.canContinueSimulation()) {
+        simulation.performNextTrade();
+        publish(WholeSnapshot);
+    }
+}
+
+SimulationSnapshot SimulationWorker::takeSnapshot()
+{
+    return simulation.takeSnapshot();
+}
+
+void SimulationWorker::onTimeout()
+{
+    if (!simulation.canContinueSimulation()) {
+        timer->stop();
+        return;
+    }
+    simulation.performNextRound();
+    if (simulation.canContinueSimulation()) {
+        publish(ProgressSnapshot);
+    } else {
+        timer->stop();
+        publish(WholeSnapshot);
+    }
+}
+
+void SimulationWorker::publish(SnapshotKind kind)
+{
+    std::unique_ptr<PublishedSimulation> next(new PublishedSimulation);
+    if (kind == ProgressSnapshot) {
+        next->simulation = simulation.takeProgressSnapshot();
+        next->nextSituation = std::make_shared<EdgeworthSituation const>(simulation.getNextSituation());
+    } else {
+        next->simulation = simulation.takeSnapshot();
+    }
+    publishedProgressOnly = kind == ProgressSnapshot;
+    next->lastRoundProfile = simulation.getLastRoundProfile();
+    next->totalProfile = simulation.getTotalProfile();
+    next->generation = generation;
+    std::unique_ptr<PublishedSimulation> const replaced(mailbox.exchange(next.release()));
+    if (!replaced) {
+        emit published();
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef SIMULATIONWORKER_H
+#define SIMULATIONWORKER_H
+
+#include <QObject>
+#include <QMetaType>
+#include <atomic>
+#include <memory>
+
+#include "model.h"
+
+class QTimer;
+
+Q_DECLARE_METATYPE(SimulationSnapshot)
+
+//What the worker hands over to the window: a snapshot of its simulation, shown as it is,
+//and the profiles, which the snapshot does not carry over. While the timer runs the rounds
+//the snapshot leaves out the actors (see Simulation::takeProgressSnapshot), so neither side copies them per round;
+//the next situation comes along instead. Pausing, stepping and stopping publish the whole simulation.
+struct PublishedSimulation
+{
+    SimulationSnapshot simulation;
+    //set when the snapshot has no actors to compute it from
+    std::shared_ptr<EdgeworthSituation const> nextSituation;
+    RoundProfile lastRoundProfile;
+    RoundProfile totalProfile;
+    //the load the simulation continues, older generations are stale for the window
+    quint64 generation;
+};
+
+//Runs the simulation on its own thread. The window sends the commands as queued calls
+//and takes the published snapshots out of a single-slot mailbox: only the newest one is kept,
+//so a slow window skips rounds instead of piling them up.
+class SimulationWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SimulationWorker(QObject* parent = 0);
+    ~SimulationWorker();
+
+    //Lock-free, callable from any thread. Null if nothing was published since the last call.
+    std::unique_ptr<PublishedSimulation> takePublished();
+
+public slots:
+    void load(SimulationSnapshot simulation, quint64 generation);
+    void start(int interval);
+    void pause();
+    void setInterval(int interval);
+    void performNextRound();
+    void performNextTrade();
+    //The whole simulation, for the window to save or keep while the rounds run. Called blocking,
+    //it is answered between two rounds.
+    SimulationSnapshot takeSnapshot();
+
+signals:
+    //emitted only when the mailbox was empty, a pending signal covers the later snapshots too
+    void published();
+
+private slots:
+    void onTimeout();
+
+private:
+    enum SnapshotKind { WholeSnapshot, ProgressSnapshot };
+    void publish(SnapshotKind kind);
+
+    Simulation simulation;
+    //so a pause publishes the actors only if the window lacks them
+    bool publishedProgressOnly;
+    quint64 generation;
+    //owned by the worker, lives on its thread
+    QTimer* timer;
+    std::atomic<PublishedSimulation*> mailbox;
+};
+
+#endif // SIMULATIONWORKER_H
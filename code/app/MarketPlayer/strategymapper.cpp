@@ -72,3 +72,13 @@ unique_ptr<AbstractAcceptanceStrategy> createAcceptanceStrategy(QString name)
     }
     return result;
 }
+
+bool isOfferStrategyName(QString name)
+{
+    return name == oppositeParetoValue || name == randomParetoValue || name == randomTriangleValue;
+}
+
+bool isAcceptanceStrategyName(QString name)
+{
+    return name == alwaysValue || name == higherGainValue || name == higherProportionValue;
+}
@@ -39,4 +39,7 @@ private:
 unique_ptr<AbstractOfferStrategy> createOfferStrategy(QString name);
 unique_ptr<AbstractAcceptanceStrategy> createAcceptanceStrategy(QString name);
 
+bool isOfferStrategyName(QString name);
+bool isAcceptanceStrategyName(QString name);
+
 #endif // STRATEGYMAPPER_H
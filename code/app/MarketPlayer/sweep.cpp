@@ -0,0 +1,156 @@
+#include "sweep.h"
+#include "strategymapper.h"
+#include "workstealingscheduler.h"
+
+#include <QSettings>
+#include <QStringList>
+#include <mutex>
+
+QString sweepGroupKey = "sweep";
+QString sweepNumActorsKey = "num_actors";
+QString sweepAlfa1Key = "alfa1";
+QString sweepAlfa2Key = "alfa2";
+QString sweepMinTradeFactorKey = "min_trade_factor";
+QString sweepOfferStrategyKey = "offer_strategy";
+QString sweepAcceptanceStrategyKey = "acceptance_strategy";
+QString sweepRandomSeedKey = "random_seed";
+QString sweepNumSeedsKey = "num_seeds";
+
+namespace {
+
+//One swept key: the changes of the configuration, one for each of its values
+typedef std::vector<std::function<void(SimulationConfig&)>> SweepAxis;
+
+template<typename Value, typename Convert>
+bool readAxis(QSettings const& settings, QString key, Value SimulationConfig::* member, Convert convert,
+              std::vector<SweepAxis>& axes)
+{
+    SweepAxis axis;
+    for (QString const& text : settings.value(key).toStringList()) {
+        bool ok = false;
+        Value const value = convert(text.trimmed(), ok);
+        if (!ok) {
+            return false;
+        }
+        axis.push_back([member, value](SimulationConfig& config) { config.*member = value; });
+    }
+    if (!axis.empty()) {
+        axes.push_back(axis);
+    }
+    return true;
+}
+
+}
+
+bool loadSweepJobs(QString fileName, std::vector<SimulationConfig>& jobs)
+{
+    SimulationConfig base;
+    if (!loadSimulationConfig(fileName, base)) {
+        return false;
+    }
+    //the jobs already keep every core busy
+    base.numThreads = 0;
+
+    QSettings settings(fileName, QSettings::IniFormat);
+    settings.beginGroup(sweepGroupKey);
+    auto const toSize = [](QString const& text, bool& ok) { return static_cast<size_t>(text.toUInt(&ok)); };
+    auto const toDouble = [](QString const& text, bool& ok) { return text.toDouble(&ok); };
+    auto const toSeed = [](QString const& text, bool& ok) { return static_cast<URNG::result_type>(text.toUInt(&ok)); };
+    auto const toOfferStrategy = [](QString const& text, bool& ok) { ok = isOfferStrategyName(text); return text; };
+    auto const toAcceptanceStrategy = [](QString const& text, bool& ok) { ok = isAcceptanceStrategyName(text); return text; };
+
+    std::vector<SweepAxis> axes;
+    bool success = readAxis(settings, sweepNumActorsKey, &SimulationConfig::numActors, toSize, axes)
+            && readAxis(settings, sweepAlfa1Key, &SimulationConfig::alfa1, toDouble, axes)
+            && readAxis(settings, sweepAlfa2Key, &SimulationConfig::alfa2, toDouble, axes)
+            && readAxis(settings, sweepMinTradeFactorKey, &SimulationConfig::minTradeFactor, toDouble, axes)
+            && readAxis(settings, sweepOfferStrategyKey, &SimulationConfig::offerStrategy, toOfferStrategy, axes)
+            && readAxis(settings, sweepAcceptanceStrategyKey, &SimulationConfig::acceptanceStrategy, toAcceptanceStrategy, axes);
+    size_t const numAxesBeforeSeeds = axes.size();
+    success = success && readAxis(settings, sweepRandomSeedKey, &SimulationConfig::seed, toSeed, axes);
+    bool const seedsListed = axes.size() > numAxesBeforeSeeds;
+    if (success && settings.contains(sweepNumSeedsKey)) {
+        unsigned const numSeeds = settings.value(sweepNumSeedsKey).toUInt(&success);
+        success = success && numSeeds > 0 && !seedsListed;
+        SweepAxis seedAxis;
+        for (unsigned seedIdx = 0; seedIdx < numSeeds; ++seedIdx) {
+            URNG::result_type const seed = base.seed + seedIdx;
+            seedAxis.push_back([seed](SimulationConfig& config) { config.seed = seed; });
+        }
+        axes.push_back(seedAxis);
+    }
+    settings.endGroup();
+    if (!success) {
+        return false;
+    }
+
+    jobs.assign(1, base);
+    for (auto const& axis : axes) {
+        std::vector<SimulationConfig> expanded;
+        expanded.reserve(jobs.size() * axis.size());
+        for (auto const& job : jobs) {
+            for (auto const& change : axis) {
+                expanded.push_back(job);
+                change(expanded.back());
+            }
+        }
+        jobs.swap(expanded);
+    }
+    return true;
+}
+
+bool runEnsemble(const SimulationConfig &config, size_t firstRunIdx, size_t numRuns, size_t numThreads, Ensemble &ensemble,
+                 const std::atomic<bool> *canceled, const EnsembleRunFinished &onRunFinished)
+{
+    auto isCanceled = [canceled]() { return canceled && canceled->load(); };
+    std::mutex foldMutex;
+    bool success = true;
+    size_t numFinishedRuns = 0;
+    WorkStealingScheduler scheduler(numThreads);
+    scheduler.run(numRuns, [&](size_t runIdx) {
+        if (isCanceled()) {
+            return;
+        }
+        SimulationConfig runConfig = config;
+        runConfig.seed = config.seed + firstRunIdx + runIdx;
+        runConfig.numThreads = 0;
+        Simulation simulation;
+        std::vector<Ensemble::RoundValues> run;
+        bool const runSuccess = setupSimulationByConfig(simulation, runConfig);
+        if (runSuccess) {
+            run.push_back(Ensemble::takeLastRound(simulation.history));
+        }
+        while (runSuccess && simulation.canContinueSimulation()) {
+            if (isCanceled()) {
+                return;
+            }
+            simulation.performNextRound();
+            run.push_back(Ensemble::takeLastRound(simulation.history));
+        }
+        std::lock_guard<std::mutex> lock(foldMutex);
+        if (runSuccess) {
+            ensemble.addRun(run);
+        }
+        success = success && runSuccess;
+        ++numFinishedRuns;
+        if (onRunFinished) {
+            onRunFinished(numFinishedRuns);
+        }
+    });
+    return success;
+}
+
+void runSweep(const std::vector<SimulationConfig> &jobs, size_t numThreads, const SweepJobFinished &onJobFinished)
+{
+    std::mutex finishedMutex;
+    WorkStealingScheduler scheduler(numThreads);
+    scheduler.run(jobs.size(), [&](size_t jobIdx) {
+        Simulation simulation;
+        bool const success = setupSimulationByConfig(simulation, jobs[jobIdx]);
+        while (success && simulation.canContinueSimulation()) {
+            simulation.performNextRound();
+        }
+        std::lock_guard<std::mutex> lock(finishedMutex);
+        onJobFinished(jobIdx, success ? &simulation : nullptr);
+    });
+}
@@ -0,0 +1,36 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "simulationconfig.h"
+#include "ensemble.h"
+
+//A sweep spec is a configuration file with an additional [sweep] group listing comma separated values
+//for some of num_actors, alfa1, alfa2, min_trade_factor, offer_strategy, acceptance_strategy and
+//random_seed (or num_seeds: that many seeds counting up from the random_seed of the configuration).
+//Every combination of the listed values is one job, the last key varying fastest.
+bool loadSweepJobs(QString fileName, std::vector<SimulationConfig>& jobs);
+
+//Called once a job has run until the simulation could not continue, simulation is null if its setup failed.
+//Calls are serialized, but they come from the threads running the jobs.
+typedef std::function<void(size_t jobIdx, Simulation const* simulation)> SweepJobFinished;
+
+//Runs the jobs on numThreads threads, each job single-threaded, longer jobs do not hold up the others
+void runSweep(std::vector<SimulationConfig> const& jobs, size_t numThreads, SweepJobFinished const& onJobFinished);
+
+//Called after each run of an ensemble with the number of runs done so far, from the threads running them
+typedef std::function<void(size_t numFinishedRuns)> EnsembleRunFinished;
+
+//Runs the runs firstRunIdx .. firstRunIdx+numRuns-1 of the configuration, run i using the seed config.seed+i,
+//and folds each into the ensemble when it finishes. Only the runs in progress keep their series.
+//The result is independent of the thread count up to the rounding of the order the runs finish in.
+//Once canceled is set, the runs stop between two rounds and are left out; the finished ones stay in the ensemble.
+bool runEnsemble(SimulationConfig const& config, size_t firstRunIdx, size_t numRuns, size_t numThreads, Ensemble& ensemble,
+                 std::atomic<bool> const* canceled = nullptr,
+                 EnsembleRunFinished const& onRunFinished = EnsembleRunFinished());
+
+#endif // SWEEP_H
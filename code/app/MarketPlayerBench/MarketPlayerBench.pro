@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Benchmarks of the MarketPlayer model, build in release mode
+#
+#-------------------------------------------------
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+QT       += core
+QT       -= gui
+
+TARGET = marketplayer-bench
+TEMPLATE = app
+
+MARKETPLAYER_DIR = ../MarketPlayer
+
+include($$MARKETPLAYER_DIR/model/model.pri)
+
+INCLUDEPATH += $$MARKETPLAYER_DIR
+
+SOURCES += main.cpp \
+    benchmarks.cpp \
+    allocationcounter.cpp \
+    verify.cpp \
+    $$MARKETPLAYER_DIR/strategymapper.cpp
+
+HEADERS += benchmarks.h \
+    allocationcounter.h \
+    verify.h \
+    $$MARKETPLAYER_DIR/strategymapper.h
@@ -0,0 +1,86 @@
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> numAllocations(0);
+std::atomic<uint64_t> numBytes(0);
+
+void countAllocation(size_t size)
+{
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    numBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+}
+
+AllocationCount getAllocationCount()
+{
+    return AllocationCount{numAllocations.load(), numBytes.load()};
+}
+
+#ifdef __GLIBC__
+
+//The definitions in the executable take precedence over the ones of the C library for every module,
+//the allocator of the library stays reachable through its internal names.
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(size_t size)
+{
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size)
+{
+    countAllocation(num * size);
+    return __libc_calloc(num, size);
+}
+
+void* realloc(void* pointer, size_t size)
+{
+    countAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer)
+{
+    __libc_free(pointer);
+}
+
+int posix_memalign(void** pointer, size_t alignment, size_t size)
+{
+    countAllocation(size);
+    *pointer = __libc_memalign(alignment, size);
+    return *pointer ? 0 : ENOMEM;
+}
+
+}
+
+#else
+
+void* operator new(size_t size)
+{
+    countAllocation(size);
+    if (void* pointer = std::malloc(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+#endif
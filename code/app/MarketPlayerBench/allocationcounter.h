@@ -0,0 +1,20 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+//Heap allocations of the whole process since it started, freeing is not subtracted.
+//With glibc every malloc is counted, the Qt containers included, elsewhere only operator new.
+struct AllocationCount
+{
+    uint64_t numAllocations;
+    uint64_t numBytes;
+
+    AllocationCount operator-(AllocationCount const& other) const {
+        return AllocationCount{numAllocations - other.numAllocations, numBytes - other.numBytes};
+    }
+};
+
+AllocationCount getAllocationCount();
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,224 @@
+#include "benchmarks.h"
+#include "model.h"
+#include "goodseconomy.h"
+#include "strategymapper.h"
+
+#include <QElapsedTimer>
+
+namespace {
+
+URNG::result_type const benchmarkSeed = 20160601;
+//enough pairs for the strategies to see varied situations, few enough to stay in the cache
+size_t const maxSampledSituations = 4096;
+
+void setupBenchmarkSimulation(Simulation& simulation, size_t numActors, size_t numThreads)
+{
+    simulation.setup(benchmarkSeed, numActors, 1000, 1000, 0.5, 0.5, 0.01, 2);
+    simulation.setStrategies(createOfferStrategy(randomTriangleValue), createAcceptanceStrategy(higherGainValue));
+    simulation.setNumThreads(numThreads);
+}
+
+//Repeats operation until it ran at least minSeconds. operation returns whether it may be repeated.
+template<typename Operation>
+BenchmarkResult measure(QString name, QString operationName, size_t numActors, size_t numThreads,
+                        double tradesPerOperation, double minSeconds, size_t maxOperations, Operation operation)
+{
+    BenchmarkResult result;
+    result.name = name;
+    result.operation = operationName;
+    result.numActors = numActors;
+    result.numThreads = numThreads;
+    result.tradesPerOperation = tradesPerOperation;
+    result.numOperations = 0;
+
+    AllocationCount const allocationsBefore = getAllocationCount();
+    QElapsedTimer timer;
+    timer.start();
+    bool canRepeat = true;
+    while (canRepeat && result.numOperations < maxOperations &&
+           (result.numOperations == 0 || timer.nsecsElapsed() < minSeconds * 1e9)) {
+        canRepeat = operation();
+        ++result.numOperations;
+    }
+    result.seconds = timer.nsecsElapsed() * 1e-9;
+    result.allocations = getAllocationCount() - allocationsBefore;
+    return result;
+}
+
+void benchmarkTrades(BenchmarkSettings const& settings, size_t numActors, BenchmarkResultHandler const& onResult)
+{
+    Simulation simulation;
+    setupBenchmarkSimulation(simulation, numActors, 0);
+    onResult(measure("performNextTrade", "trade", numActors, 1, 1.0, settings.minSeconds, numActors / 2,
+                     [&simulation]() {
+        simulation.performNextTrade();
+        return simulation.canContinueSimulation();
+    }));
+}
+
+//Measured from the start of a simulation, where most pairs trade
+void benchmarkRounds(BenchmarkSettings const& settings, size_t numActors, BenchmarkResultHandler const& onResult)
+{
+    Simulation simulation;
+    setupBenchmarkSimulation(simulation, numActors, settings.numThreads);
+    onResult(measure("performNextRound", "round", numActors, settings.numThreads, numActors / 2,
+                     settings.minSeconds, settings.maxRounds, [&simulation]() {
+        simulation.performNextRound();
+        return simulation.canContinueSimulation();
+    }));
+
+    onResult(measure("saveHistory", "call", numActors, 1, 0.0, settings.minSeconds, SIZE_MAX, [&simulation]() {
+        simulation.saveHistory();
+        return true;
+    }));
+    onResult(measure("rebuildDistributions", "call", numActors, 1, 0.0, settings.minSeconds, SIZE_MAX, [&simulation]() {
+        simulation.rebuildDistributions();
+        return true;
+    }));
+
+    ConstAmountSpan const q1(simulation.actors.q1.data(), numActors);
+    HistogramLayout const linearLayout = HistogramLayout::linear(simulation.getSumQ1() / numActors / 8,
+                                                                 HistogramSettings::defaultMaxBuckets);
+    onResult(measure("HeavyDistribution::setup", "call", numActors, 1, 0.0, settings.minSeconds, SIZE_MAX, [&]() {
+        HeavyDistribution distribution;
+        distribution.setup(q1, linearLayout);
+        return true;
+    }));
+    HistogramLayout const logLayout = HistogramLayout::logarithmic(simulation.getSumQ1() / numActors / 1000,
+                                                                   simulation.getSumQ1(),
+                                                                   HistogramSettings::defaultMaxBuckets);
+    onResult(measure("HeavyDistribution::setup log", "call", numActors, 1, 0.0, settings.minSeconds, SIZE_MAX, [&]() {
+        HeavyDistribution distribution;
+        distribution.setup(q1, logLayout);
+        return true;
+    }));
+    volatile Amount_t deviationSink = 0.0;
+    onResult(measure("calculateStandardDeviation", "call", numActors, 1, 0.0, settings.minSeconds, SIZE_MAX, [&]() {
+        deviationSink = calculateStandardDeviation(q1);
+        return true;
+    }));
+}
+
+//Rounds with the number of goods fixed at compile time, the trades of two goods are those of Simulation
+//with the random pareto offer and the higher gain acceptance
+template<size_t NumGoods>
+void benchmarkGoodsRounds(BenchmarkSettings const& settings, size_t numActors, BenchmarkResultHandler const& onResult)
+{
+    std::array<Amount_t, NumGoods> amounts;
+    amounts.fill(1000);
+    std::array<double, NumGoods> alfas;
+    alfas.fill(1.0 / NumGoods);
+    GoodsEconomy<NumGoods> economy;
+    economy.setup(benchmarkSeed, numActors, amounts, alfas, 0.01);
+    economy.setNumThreads(settings.numThreads);
+    onResult(measure(QString("GoodsEconomy<%1>::performNextRound").arg(NumGoods), "round", numActors, settings.numThreads,
+                     numActors / 2, settings.minSeconds, settings.maxRounds, [&economy]() {
+        economy.performNextRound();
+        return true;
+    }));
+}
+
+template<typename Strategy>
+void benchmarkOffer(QString name, std::vector<unique_ptr<EdgeworthSituation>> const& situations,
+                    BenchmarkSettings const& settings, size_t numActors, BenchmarkResultHandler const& onResult)
+{
+    Strategy const strategy;
+    URNG rng(benchmarkSeed);
+    size_t situationIdx = 0;
+    volatile Amount_t sink = 0.0;
+    onResult(measure(name + "::propose", "call", numActors, 1, 0.0, settings.minSeconds, SIZE_MAX, [&]() {
+        sink = strategy.propose(*situations[situationIdx], rng).q1;
+        situationIdx = (situationIdx + 1) % situations.size();
+        return true;
+    }));
+}
+
+template<typename Strategy>
+void benchmarkAcceptance(QString name, std::vector<unique_ptr<EdgeworthSituation>> const& situations,
+                         BenchmarkSettings const& settings, size_t numActors, BenchmarkResultHandler const& onResult)
+{
+    Strategy const strategy;
+    size_t situationIdx = 0;
+    volatile bool sink = false;
+    onResult(measure(name + "::consider", "call", numActors, 1, 0.0, settings.minSeconds, SIZE_MAX, [&]() {
+        sink = strategy.consider(*situations[situationIdx]);
+        situationIdx = (situationIdx + 1) % situations.size();
+        return true;
+    }));
+}
+
+//The strategies are called on the situations of the first pairs of a fresh simulation
+void benchmarkStrategies(BenchmarkSettings const& settings, size_t numActors, BenchmarkResultHandler const& onResult)
+{
+    Simulation simulation;
+    setupBenchmarkSimulation(simulation, numActors, 0);
+    RandomTriangleOfferStrategy const offerStrategy;
+    HigherGainAcceptanceStrategy const acceptanceStrategy;
+    std::vector<unique_ptr<EdgeworthSituation>> situations;
+    for (size_t pairIdx = 0; pairIdx < std::min(simulation.progress.getNum(), maxSampledSituations); ++pairIdx) {
+        size_t actor1Idx, actor2Idx;
+        std::tie(actor1Idx, actor2Idx) = simulation.progress.getPair(pairIdx);
+        URNG rng = simulation.createTradeStream(pairIdx);
+        situations.emplace_back(new EdgeworthSituation(simulation, actor1Idx, actor2Idx,
+                                                       offerStrategy, acceptanceStrategy, rng));
+    }
+
+    benchmarkOffer<OppositeParetoOfferStrategy>("OppositeParetoOfferStrategy", situations, settings, numActors, onResult);
+    benchmarkOffer<RandomParetoOfferStrategy>("RandomParetoOfferStrategy", situations, settings, numActors, onResult);
+    benchmarkOffer<RandomTriangleOfferStrategy>("RandomTriangleOfferStrategy", situations, settings, numActors, onResult);
+    benchmarkAcceptance<AlwaysAcceptanceStrategy>("AlwaysAcceptanceStrategy", situations, settings, numActors, onResult);
+    benchmarkAcceptance<HigherGainAcceptanceStrategy>("HigherGainAcceptanceStrategy", situations, settings, numActors, onResult);
+    benchmarkAcceptance<HigherProportionAcceptanceStrategy>("HigherProportionAcceptanceStrategy", situations, settings, numActors, onResult);
+}
+
+}
+
+BenchmarkSettings::BenchmarkSettings()
+    : populations({1000, 10000, 100000, 1000000, 10000000})
+    , numThreads(1)
+    , minSeconds(0.5)
+    , maxRounds(20)
+{
+}
+
+double BenchmarkResult::getNanosecondsPerOperation() const
+{
+    return numOperations > 0 ? seconds * 1e9 / numOperations : 0.0;
+}
+
+double BenchmarkResult::getOperationsPerSecond() const
+{
+    return seconds > 0.0 ? numOperations / seconds : 0.0;
+}
+
+double BenchmarkResult::getTradesPerSecond() const
+{
+    return getOperationsPerSecond() * tradesPerOperation;
+}
+
+double BenchmarkResult::getNanosecondsPerTrade() const
+{
+    return tradesPerOperation > 0.0 ? getNanosecondsPerOperation() / tradesPerOperation : 0.0;
+}
+
+double BenchmarkResult::getBytesPerOperation() const
+{
+    return numOperations > 0 ? static_cast<double>(allocations.numBytes) / numOperations : 0.0;
+}
+
+double BenchmarkResult::getAllocationsPerOperation() const
+{
+    return numOperations > 0 ? static_cast<double>(allocations.numAllocations) / numOperations : 0.0;
+}
+
+void runBenchmarks(const BenchmarkSettings &settings, const BenchmarkResultHandler &onResult)
+{
+    for (size_t numActors : settings.populations) {
+        benchmarkTrades(settings, numActors, onResult);
+        benchmarkRounds(settings, numActors, onResult);
+        benchmarkGoodsRounds<2>(settings, numActors, onResult);
+        benchmarkGoodsRounds<3>(settings, numActors, onResult);
+        benchmarkGoodsRounds<5>(settings, numActors, onResult);
+        benchmarkStrategies(settings, numActors, onResult);
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QString>
+#include <functional>
+#include <vector>
+
+#include "allocationcounter.h"
+
+struct BenchmarkSettings
+{
+    std::vector<size_t> populations;
+    //threads of performNextRound, the other benchmarks run on the calling thread
+    size_t numThreads;
+    //every benchmark repeats its operation at least this long
+    double minSeconds;
+    //rounds performNextRound is measured on at most, from the start of a simulation
+    size_t maxRounds;
+
+    BenchmarkSettings();
+};
+
+//One operation (a trade, a round, a call) measured numOperations times
+struct BenchmarkResult
+{
+    QString name;
+    QString operation;
+    size_t numActors;
+    size_t numThreads;
+    size_t numOperations;
+    double seconds;
+    //trades an operation attempts, zero if it does not trade
+    double tradesPerOperation;
+    AllocationCount allocations;
+
+    double getNanosecondsPerOperation() const;
+    double getOperationsPerSecond() const;
+    double getTradesPerSecond() const;
+    double getNanosecondsPerTrade() const;
+    double getBytesPerOperation() const;
+    double getAllocationsPerOperation() const;
+};
+
+typedef std::function<void(BenchmarkResult const&)> BenchmarkResultHandler;
+
+//Runs every benchmark for every population, reporting each result as soon as it is measured
+void runBenchmarks(BenchmarkSettings const& settings, BenchmarkResultHandler const& onResult);
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,161 @@
+#include <QCoreApplication>
+#include <QStringList>
+#include <QFile>
+#include <QTextStream>
+
+#include <iostream>
+
+#include "benchmarks.h"
+#include "verify.h"
+
+using std::cerr;
+using std::endl;
+
+namespace {
+
+void printUsage()
+{
+    cerr << "Usage: marketplayer-bench [options]" << endl
+         << "Options:" << endl
+         << "  --sizes <n1,n2,...>   populations to measure, 1000 to 10000000 by default" << endl
+         << "  --max-actors <n>      skip the populations larger than this" << endl
+         << "  --rounds <n>          rounds performNextRound is measured on at most, 20 by default" << endl
+         << "  --threads <n>         threads of performNextRound, 1 by default" << endl
+         << "  --min-time <seconds>  time each benchmark runs at least, 0.5 by default" << endl
+         << "  --format <csv|json>   csv by default" << endl
+         << "  --output <file>       standard output by default" << endl
+         << "  --verify              instead of measuring, check the random streams against the Philox known" << endl
+         << "                        answers and that the results do not depend on the threads" << endl
+         << "                        (--sizes, --rounds and --threads apply, 10000,100000 actors, 5 rounds" << endl
+         << "                        and all cores by default), exits with 1 if a check fails" << endl;
+}
+
+QStringList const columnNames = {
+    "benchmark", "num_actors", "threads", "op", "iterations",
+    "ns_per_op", "ops_per_sec", "ns_per_trade", "trades_per_sec",
+    "bytes_per_op", "allocations_per_op"
+};
+
+QStringList getColumnValues(BenchmarkResult const& result)
+{
+    return {
+        result.name, QString::number(result.numActors), QString::number(result.numThreads),
+        result.operation, QString::number(result.numOperations),
+        QString::number(result.getNanosecondsPerOperation()),
+        QString::number(result.getOperationsPerSecond()),
+        QString::number(result.getNanosecondsPerTrade()),
+        QString::number(result.getTradesPerSecond()),
+        QString::number(result.getBytesPerOperation()),
+        QString::number(result.getAllocationsPerOperation())
+    };
+}
+
+//One JSON object per line, the numbers unquoted
+QString formatJson(QStringList const& values)
+{
+    QString line = "{";
+    for (int columnIdx = 0; columnIdx < columnNames.size(); ++columnIdx) {
+        bool const isText = columnIdx == 0 || columnNames[columnIdx] == "op";
+        QString const value = isText ? "\"" + values[columnIdx] + "\"" : values[columnIdx];
+        line += (columnIdx > 0 ? ", \"" : "\"") + columnNames[columnIdx] + "\": " + value;
+    }
+    return line + "}";
+}
+
+bool parseSizes(QString argument, std::vector<size_t>& populations)
+{
+    populations.clear();
+    for (QString const& size : argument.split(",")) {
+        bool valid = false;
+        size_t const numActors = size.toUInt(&valid);
+        if (!valid || numActors < 2) {
+            return false;
+        }
+        populations.push_back(numActors);
+    }
+    return !populations.empty();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList const arguments = app.arguments();
+
+    BenchmarkSettings settings;
+    VerificationSettings verificationSettings;
+    bool verify = false;
+    size_t maxActors = 0;
+    bool json = false;
+    QString outputFileName;
+    bool validArguments = true;
+    for (int argIdx = 1; argIdx < arguments.size() && validArguments; ++argIdx) {
+        QString const& argument = arguments[argIdx];
+        bool const hasValue = argIdx + 1 < arguments.size();
+        if (argument == "--sizes" && hasValue) {
+            validArguments = parseSizes(arguments[++argIdx], settings.populations);
+            verificationSettings.populations = settings.populations;
+        } else if (argument == "--max-actors" && hasValue) {
+            maxActors = arguments[++argIdx].toUInt(&validArguments);
+        } else if (argument == "--rounds" && hasValue) {
+            settings.maxRounds = arguments[++argIdx].toUInt(&validArguments);
+            validArguments = validArguments && settings.maxRounds > 0;
+            verificationSettings.maxRounds = settings.maxRounds;
+        } else if (argument == "--threads" && hasValue) {
+            settings.numThreads = arguments[++argIdx].toUInt(&validArguments);
+            verificationSettings.numThreads = settings.numThreads;
+        } else if (argument == "--min-time" && hasValue) {
+            settings.minSeconds = arguments[++argIdx].toDouble(&validArguments);
+        } else if (argument == "--format" && hasValue) {
+            QString const format = arguments[++argIdx];
+            json = format == "json";
+            validArguments = json || format == "csv";
+        } else if (argument == "--output" && hasValue) {
+            outputFileName = arguments[++argIdx];
+        } else if (argument == "--verify") {
+            verify = true;
+        } else {
+            validArguments = false;
+        }
+    }
+    if (!validArguments) {
+        printUsage();
+        return 1;
+    }
+    if (maxActors > 0) {
+        auto const isTooLarge = [maxActors](size_t numActors) { return numActors > maxActors; };
+        settings.populations.erase(std::remove_if(settings.populations.begin(), settings.populations.end(), isTooLarge),
+                                   settings.populations.end());
+        verificationSettings.populations.erase(std::remove_if(verificationSettings.populations.begin(),
+                                                              verificationSettings.populations.end(), isTooLarge),
+                                               verificationSettings.populations.end());
+    }
+
+    QFile file(outputFileName);
+    bool const opened = outputFileName.isEmpty()
+            ? file.open(stdout, QIODevice::WriteOnly | QIODevice::Text)
+            : file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+    if (!opened) {
+        cerr << "Could not write output file " << outputFileName.toStdString() << endl;
+        return 1;
+    }
+    QTextStream out(&file);
+    if (verify) {
+        bool const passed = runVerification(verificationSettings, [&](VerificationResult const& result) {
+            out << (result.passed ? "PASS " : "FAIL ") << result.name
+                << (result.passed ? QString() : ": " + result.detail) << '\n';
+            out.flush();
+        });
+        return passed ? 0 : 1;
+    }
+    if (!json) {
+        out << columnNames.join(",") << '\n';
+    }
+    runBenchmarks(settings, [&](BenchmarkResult const& result) {
+        QStringList const values = getColumnValues(result);
+        out << (json ? formatJson(values) : values.join(",")) << '\n';
+        out.flush();
+    });
+    return 0;
+}
@@ -0,0 +1,313 @@
+#include "verify.h"
+#include "model.h"
+#include "goodseconomy.h"
+#include "strategymapper.h"
+
+#include <QStringList>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+URNG::result_type const verificationSeed = 20160601;
+
+struct UtilityExponents
+{
+    double alfa1, alfa2;
+};
+
+//the square root and the general closed form of the utility
+UtilityExponents const verifiedExponents[] = {{0.5, 0.5}, {0.3, 0.7}};
+
+//Known answers of Philox4x32-10 from the Random123 distribution (kat_vectors)
+struct PhiloxKnownAnswer
+{
+    uint32_t counter[4];
+    uint32_t key[2];
+    uint32_t block[4];
+};
+
+PhiloxKnownAnswer const philoxKnownAnswers[] = {
+    {{0x00000000, 0x00000000, 0x00000000, 0x00000000}, {0x00000000, 0x00000000},
+     {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+    {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff},
+     {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+    {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0},
+     {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}
+};
+
+QString formatWords(uint32_t const* words, size_t count)
+{
+    QStringList hexWords;
+    for (size_t wordIdx = 0; wordIdx < count; ++wordIdx) {
+        hexWords.append(QString("%1").arg(words[wordIdx], 8, 16, QChar('0')));
+    }
+    return hexWords.join(" ");
+}
+
+void verifyPhiloxKnownAnswers(VerificationResultHandler const& onResult, bool& allPassed)
+{
+    for (PhiloxKnownAnswer const& answer : philoxKnownAnswers) {
+        uint32_t block[4];
+        Philox4x32::computeBlock(answer.counter, answer.key, block);
+        VerificationResult result;
+        result.name = QString("Philox4x32-10 known answer, counter %1, key %2")
+                .arg(formatWords(answer.counter, 4)).arg(formatWords(answer.key, 2));
+        result.passed = std::equal(block, block + 4, answer.block);
+        if (!result.passed) {
+            result.detail = QString("got %1, expected %2").arg(formatWords(block, 4)).arg(formatWords(answer.block, 4));
+        }
+        allPassed = allPassed && result.passed;
+        onResult(result);
+    }
+}
+
+//A stream draws the blocks of the counters (draw index low, high, streamLow, streamHigh) in order,
+//the carry into the high word and setPosition included
+void verifyPhiloxStreams(VerificationResultHandler const& onResult, bool& allPassed)
+{
+    uint64_t const key = (static_cast<uint64_t>(Simulation::TradeStream) << 32) | verificationSeed;
+    uint32_t const keyWords[2] = {static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)};
+    uint32_t const streamHigh = 7, streamLow = 1234567;
+    uint64_t const blockNumbers[] = {0, 1, 0xFFFFFFFFull, 0x100000000ull};
+
+    VerificationResult result;
+    result.name = "Philox4x32 streams draw the blocks of their counters";
+    for (uint64_t blockNumber : blockNumbers) {
+        uint32_t const counter[4] = {static_cast<uint32_t>(blockNumber), static_cast<uint32_t>(blockNumber >> 32),
+                                     streamLow, streamHigh};
+        uint32_t expected[4];
+        Philox4x32::computeBlock(counter, keyWords, expected);
+        for (uint32_t offset = 0; offset < 4 && result.detail.isEmpty(); ++offset) {
+            Philox4x32 positioned(key, streamHigh, streamLow);
+            positioned.setPosition(blockNumber * 4 + offset);
+            //drawn up to the position from the start of the block before, across the carry
+            Philox4x32 stepped(key, streamHigh, streamLow);
+            uint64_t const start = blockNumber > 0 ? (blockNumber - 1) * 4 : 0;
+            stepped.setPosition(start);
+            for (uint64_t position = start; position < blockNumber * 4 + offset; ++position) {
+                stepped();
+            }
+            uint32_t const positionedDraw = positioned();
+            uint32_t const steppedDraw = stepped();
+            if (positionedDraw != expected[offset] || steppedDraw != expected[offset]) {
+                result.detail = QString("draw %1 of block %2").arg(offset).arg(blockNumber);
+            }
+        }
+    }
+    result.passed = result.detail.isEmpty();
+    allPassed = allPassed && result.passed;
+    onResult(result);
+}
+
+//Bit for bit, so that the signs of zeros and the payloads of NaNs count too
+template<typename ColumnA, typename ColumnB>
+bool isSameColumn(ColumnA const& a, ColumnB const& b, size_t& firstDifference)
+{
+    size_t const size = std::min(a.size(), b.size());
+    for (firstDifference = 0; firstDifference < size; ++firstDifference) {
+        if (std::memcmp(a.data() + firstDifference, b.data() + firstDifference, sizeof(Amount_t)) != 0) {
+            return false;
+        }
+    }
+    return a.size() == b.size();
+}
+
+bool isSameAmount(Amount_t a, Amount_t b)
+{
+    return std::memcmp(&a, &b, sizeof(Amount_t)) == 0;
+}
+
+//The first difference of the two simulations, empty if there is none
+QString compareSimulations(Simulation const& single, Simulation const& threaded)
+{
+    char const* const columnNames[] = {"q1", "q2", "utility"};
+    SharedAmountColumn const* const singleColumns[] = {&single.actors.q1, &single.actors.q2,
+                                                       &single.actors.utility};
+    SharedAmountColumn const* const threadedColumns[] = {&threaded.actors.q1, &threaded.actors.q2,
+                                                         &threaded.actors.utility};
+    for (size_t columnIdx = 0; columnIdx < 3; ++columnIdx) {
+        size_t actorIdx = 0;
+        if (!isSameColumn(*singleColumns[columnIdx], *threadedColumns[columnIdx], actorIdx)) {
+            return QString("%1 of actor %2").arg(columnNames[columnIdx]).arg(actorIdx);
+        }
+    }
+    if (!isSameAmount(single.roundInfo.q1Traded, threaded.roundInfo.q1Traded)
+            || !isSameAmount(single.roundInfo.q2Traded, threaded.roundInfo.q2Traded)
+            || !isSameAmount(single.roundInfo.numSuccessful, threaded.roundInfo.numSuccessful)) {
+        return "traded amounts";
+    }
+    if (!isSameAmount(single.utilityDistribution.getSum(), threaded.utilityDistribution.getSum())
+            || !isSameAmount(single.wealthDistribution.getSum(), threaded.wealthDistribution.getSum())) {
+        return "running distributions";
+    }
+    if (single.canContinueSimulation() != threaded.canContinueSimulation()) {
+        return "stopping";
+    }
+    return QString();
+}
+
+void setupVerifiedSimulation(Simulation& simulation, size_t numActors, UtilityExponents exponents,
+                             QString offerName, QString acceptanceName, size_t numThreads)
+{
+    simulation.setup(verificationSeed, numActors, 1000, 1000, exponents.alfa1, exponents.alfa2, 0.01, 2);
+    simulation.setStrategies(createOfferStrategy(offerName), createAcceptanceStrategy(acceptanceName));
+    simulation.setNumThreads(numThreads);
+}
+
+//The pairs of a round are traded in fixed blocks merged in order (user-003),
+//so a round on any number of threads gives the actor columns of the single threaded one bit for bit
+void verifyThreadCounts(VerificationSettings const& settings, size_t numActors,
+                        VerificationResultHandler const& onResult, bool& allPassed)
+{
+    QStringList const offerNames = {oppositeParetoValue, randomParetoValue, randomTriangleValue};
+    QStringList const acceptanceNames = {alwaysValue, higherGainValue, higherProportionValue};
+    for (UtilityExponents const& exponents : verifiedExponents) {
+        for (QString const& offerName : offerNames) {
+            for (QString const& acceptanceName : acceptanceNames) {
+                Simulation single, threaded;
+                setupVerifiedSimulation(single, numActors, exponents, offerName, acceptanceName, 1);
+                setupVerifiedSimulation(threaded, numActors, exponents, offerName, acceptanceName,
+                                        settings.numThreads);
+                VerificationResult result;
+                result.name = QString("threads 1 vs %1, %2 actors, alfas %3/%4, %5 offer, %6 acceptance")
+                        .arg(settings.numThreads).arg(numActors).arg(exponents.alfa1).arg(exponents.alfa2)
+                        .arg(offerName).arg(acceptanceName);
+                QString const setupDifference = compareSimulations(single, threaded);
+                if (!setupDifference.isEmpty()) {
+                    result.detail = setupDifference + " differs after the setup";
+                }
+                for (size_t roundIdx = 0; roundIdx < settings.maxRounds && result.detail.isEmpty()
+                     && single.canContinueSimulation(); ++roundIdx) {
+                    single.performNextRound();
+                    threaded.performNextRound();
+                    QString const difference = compareSimulations(single, threaded);
+                    if (!difference.isEmpty()) {
+                        result.detail = QString("%1 differs after round %2").arg(difference).arg(roundIdx + 1);
+                    }
+                }
+                result.passed = result.detail.isEmpty();
+                allPassed = allPassed && result.passed;
+                onResult(result);
+            }
+        }
+    }
+}
+
+
+//The first difference of the two economies, empty if there is none
+template<size_t NumGoods>
+QString compareEconomies(GoodsEconomy<NumGoods> const& single, GoodsEconomy<NumGoods> const& threaded)
+{
+    for (size_t goodIdx = 0; goodIdx < NumGoods; ++goodIdx) {
+        size_t actorIdx = 0;
+        if (!isSameColumn(single.getColumn(goodIdx), threaded.getColumn(goodIdx), actorIdx)) {
+            return QString("q%1 of actor %2").arg(goodIdx + 1).arg(actorIdx);
+        }
+    }
+    size_t actorIdx = 0;
+    if (!isSameColumn(single.getUtilities(), threaded.getUtilities(), actorIdx)) {
+        return QString("utility of actor %1").arg(actorIdx);
+    }
+    typename GoodsEconomy<NumGoods>::RoundInfo const& singleInfo = single.getLastRoundInfo();
+    typename GoodsEconomy<NumGoods>::RoundInfo const& threadedInfo = threaded.getLastRoundInfo();
+    bool sameInfo = isSameAmount(singleInfo.numSuccessful, threadedInfo.numSuccessful);
+    for (size_t goodIdx = 0; goodIdx < NumGoods; ++goodIdx) {
+        sameInfo = sameInfo && isSameAmount(singleInfo.traded[goodIdx], threadedInfo.traded[goodIdx]);
+    }
+    if (!sameInfo) {
+        return "traded amounts";
+    }
+    return QString();
+}
+
+//GoodsEconomy trades by the blocks of Simulation, so its rounds do not depend on the threads either
+template<size_t NumGoods>
+void verifyGoodsEconomyThreadCounts(VerificationSettings const& settings, size_t numActors,
+                                    VerificationResultHandler const& onResult, bool& allPassed)
+{
+    std::array<Amount_t, NumGoods> amounts;
+    std::array<double, NumGoods> alfas;
+    for (size_t goodIdx = 0; goodIdx < NumGoods; ++goodIdx) {
+        amounts[goodIdx] = 1000 + 100 * goodIdx;
+        alfas[goodIdx] = 0.2 + 0.1 * goodIdx;
+    }
+    GoodsEconomy<NumGoods> single, threaded;
+    single.setup(verificationSeed, numActors, amounts, alfas, 0.01);
+    threaded.setup(verificationSeed, numActors, amounts, alfas, 0.01);
+    single.setNumThreads(1);
+    threaded.setNumThreads(settings.numThreads);
+    VerificationResult result;
+    result.name = QString("GoodsEconomy<%1> threads 1 vs %2, %3 actors")
+            .arg(NumGoods).arg(settings.numThreads).arg(numActors);
+    for (size_t roundIdx = 0; roundIdx < settings.maxRounds && result.detail.isEmpty(); ++roundIdx) {
+        single.performNextRound();
+        threaded.performNextRound();
+        QString const difference = compareEconomies(single, threaded);
+        if (!difference.isEmpty()) {
+            result.detail = QString("%1 differs after round %2").arg(difference).arg(roundIdx + 1);
+        }
+    }
+    result.passed = result.detail.isEmpty();
+    allPassed = allPassed && result.passed;
+    onResult(result);
+}
+
+//With two goods GoodsEconomy trades as Simulation with the random pareto offer and the higher gain acceptance
+void verifyGoodsEconomyMatchesSimulation(VerificationSettings const& settings, size_t numActors,
+                                         VerificationResultHandler const& onResult, bool& allPassed)
+{
+    for (UtilityExponents const& exponents : verifiedExponents) {
+        Simulation simulation;
+        setupVerifiedSimulation(simulation, numActors, exponents, randomParetoValue, higherGainValue, 1);
+        GoodsEconomy<2> economy;
+        economy.setup(verificationSeed, numActors, {{1000, 1000}}, {{exponents.alfa1, exponents.alfa2}}, 0.01);
+        VerificationResult result;
+        result.name = QString("GoodsEconomy<2> vs Simulation, %1 actors, alfas %2/%3")
+                .arg(numActors).arg(exponents.alfa1).arg(exponents.alfa2);
+        for (size_t roundIdx = 0; roundIdx < settings.maxRounds && result.detail.isEmpty()
+             && simulation.canContinueSimulation(); ++roundIdx) {
+            simulation.performNextRound();
+            economy.performNextRound();
+            char const* const columnNames[] = {"q1", "q2", "utility"};
+            SharedAmountColumn const* const simulationColumns[] = {&simulation.actors.q1, &simulation.actors.q2,
+                                                                   &simulation.actors.utility};
+            for (size_t columnIdx = 0; columnIdx < 3 && result.detail.isEmpty(); ++columnIdx) {
+                size_t actorIdx = 0;
+                bool const same = columnIdx < 2 ?
+                            isSameColumn(*simulationColumns[columnIdx], economy.getColumn(columnIdx), actorIdx) :
+                            isSameColumn(*simulationColumns[columnIdx], economy.getUtilities(), actorIdx);
+                if (!same) {
+                    result.detail = QString("%1 of actor %2 differs after round %3")
+                            .arg(columnNames[columnIdx]).arg(actorIdx).arg(roundIdx + 1);
+                }
+            }
+        }
+        result.passed = result.detail.isEmpty();
+        allPassed = allPassed && result.passed;
+        onResult(result);
+    }
+}
+
+}
+
+VerificationSettings::VerificationSettings()
+    : populations({10000, 100000})
+    , numThreads(std::max(2u, std::thread::hardware_concurrency()))
+    , maxRounds(5)
+{
+}
+
+bool runVerification(VerificationSettings const& settings, VerificationResultHandler const& onResult)
+{
+    bool allPassed = true;
+    verifyPhiloxKnownAnswers(onResult, allPassed);
+    verifyPhiloxStreams(onResult, allPassed);
+    for (size_t numActors : settings.populations) {
+        verifyThreadCounts(settings, numActors, onResult, allPassed);
+        verifyGoodsEconomyMatchesSimulation(settings, numActors, onResult, allPassed);
+        verifyGoodsEconomyThreadCounts<3>(settings, numActors, onResult, allPassed);
+    }
+    return allPassed;
+}
@@ -0,0 +1,32 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <QString>
+#include <functional>
+#include <vector>
+
+struct VerificationSettings
+{
+    std::vector<size_t> populations;
+    //threads of the run compared to the single threaded one
+    size_t numThreads;
+    //rounds compared at most, the simulations may stop earlier
+    size_t maxRounds;
+
+    VerificationSettings();
+};
+
+struct VerificationResult
+{
+    QString name;
+    bool passed;
+    //the first difference found, empty if passed
+    QString detail;
+};
+
+typedef std::function<void(VerificationResult const&)> VerificationResultHandler;
+
+//Runs every check, reporting each result as soon as it is known. Returns whether all of them passed.
+bool runVerification(VerificationSettings const& settings, VerificationResultHandler const& onResult);
+
+#endif // VERIFY_H
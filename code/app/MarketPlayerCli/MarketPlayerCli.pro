@@ -0,0 +1,32 @@
+#-------------------------------------------------
+#
+# Headless batch runner sharing the model of MarketPlayer
+#
+#-------------------------------------------------
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+QT       += core
+QT       -= gui
+
+TARGET = marketplayer-cli
+TEMPLATE = app
+
+MARKETPLAYER_DIR = ../MarketPlayer
+
+include($$MARKETPLAYER_DIR/model/model.pri)
+
+INCLUDEPATH += $$MARKETPLAYER_DIR
+
+SOURCES += main.cpp \
+    historywriter.cpp \
+    $$MARKETPLAYER_DIR/strategymapper.cpp \
+    $$MARKETPLAYER_DIR/simulationconfig.cpp \
+    $$MARKETPLAYER_DIR/checkpoint.cpp \
+    $$MARKETPLAYER_DIR/sweep.cpp
+
+HEADERS += historywriter.h \
+    $$MARKETPLAYER_DIR/strategymapper.h \
+    $$MARKETPLAYER_DIR/simulationconfig.h \
+    $$MARKETPLAYER_DIR/checkpoint.h \
+    $$MARKETPLAYER_DIR/sweep.h
@@ -0,0 +1,100 @@
+#include "historywriter.h"
+
+#include <QFile>
+#include <cmath>
+
+namespace {
+
+QString const seriesColumns = "round,q1_traded,q2_traded,num_successful,sum_utilities,wealth_deviation,"
+                              "wealth_gini,wealth_p10,wealth_p50,wealth_p90,wealth_p99,wealth_top1_share";
+QString const seriesNames[Ensemble::NumSeries] = {"q1_traded", "q2_traded", "num_successful", "sum_utilities", "wealth_deviation",
+                                                  "wealth_gini", "wealth_p10", "wealth_p50", "wealth_p90", "wealth_p99",
+                                                  "wealth_top1_share"};
+
+void writeSeriesRows(QTextStream& out, QString const& rowPrefix, History const& history)
+{
+    for (size_t idx = 0; idx < history.getNumRetained(); ++idx) {
+        out << rowPrefix
+            << history.getTime(idx) << ','
+            << history.q1Traded[idx] << ','
+            << history.q2Traded[idx] << ','
+            << history.numSuccessful[idx] << ','
+            << history.sumUtilities[idx] << ','
+            << history.wealthDeviation[idx] << ','
+            << history.wealthGini[idx] << ','
+            << history.wealthP10[idx] << ','
+            << history.wealthP50[idx] << ','
+            << history.wealthP90[idx] << ','
+            << history.wealthP99[idx] << ','
+            << history.wealthTopShare[idx] << '\n';
+    }
+}
+
+}
+
+bool writeHistorySeries(QString fileName, const History &history)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream out(&file);
+    out.setRealNumberPrecision(12);
+    out << seriesColumns << '\n';
+    writeSeriesRows(out, "", history);
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+bool writeEnsembleBands(QString fileName, const Ensemble &ensemble)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream out(&file);
+    out.setRealNumberPrecision(12);
+    out << "round,runs";
+    for (auto const& name : seriesNames) {
+        out << ',' << name << "_mean," << name << "_stddev," << name << "_ci_low," << name << "_ci_high";
+    }
+    out << '\n';
+    std::vector<EnsembleBand> bands;
+    for (size_t series = 0; series < Ensemble::NumSeries; ++series) {
+        bands.push_back(ensemble.calculateBand(static_cast<Ensemble::Series>(series)));
+    }
+    for (size_t round = 0; round < ensemble.getNumRounds(); ++round) {
+        out << round << ',' << ensemble.getMoments(round, Ensemble::Q1Traded).getCount();
+        for (size_t series = 0; series < Ensemble::NumSeries; ++series) {
+            RunningMoments const& moments = ensemble.getMoments(round, static_cast<Ensemble::Series>(series));
+            out << ',' << moments.getMean()
+                << ',' << std::sqrt(moments.calculateVariance())
+                << ',' << bands[series].lower.y[round]
+                << ',' << bands[series].upper.y[round];
+        }
+        out << '\n';
+    }
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+void writeSweepHeader(QTextStream &out)
+{
+    out << "job,num_actors,alfa1,alfa2,min_trade_factor,offer_strategy,acceptance_strategy,seed,"
+        << seriesColumns << '\n';
+    out.flush();
+}
+
+void writeSweepJob(QTextStream &out, size_t jobIdx, const SimulationConfig &config, const History &history)
+{
+    QString const rowPrefix = QString::number(jobIdx) + "," +
+            QString::number(config.numActors) + "," +
+            QString::number(config.alfa1) + "," +
+            QString::number(config.alfa2) + "," +
+            QString::number(config.minTradeFactor) + "," +
+            config.offerStrategy + "," +
+            config.acceptanceStrategy + "," +
+            QString::number(config.seed) + ",";
+    writeSeriesRows(out, rowPrefix, history);
+    out.flush();
+}
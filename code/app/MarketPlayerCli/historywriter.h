@@ -0,0 +1,23 @@
+#ifndef HISTORYWRITER_H
+#define HISTORYWRITER_H
+
+#include <QString>
+#include <QTextStream>
+
+#include "model.h"
+#include "simulationconfig.h"
+#include "ensemble.h"
+
+//Writes the per-round series of a history as comma separated values,
+//one line per round.
+bool writeHistorySeries(QString fileName, History const& history);
+
+//Results of a sweep: the series of every job in one file, each line prefixed by the job and its parameters.
+//The jobs are written as they finish, so their order in the file varies from run to run.
+void writeSweepHeader(QTextStream& out);
+void writeSweepJob(QTextStream& out, size_t jobIdx, SimulationConfig const& config, History const& history);
+
+//Per round the number of runs, then the mean, standard deviation and 95% confidence interval of each series
+bool writeEnsembleBands(QString fileName, Ensemble const& ensemble);
+
+#endif // HISTORYWRITER_H
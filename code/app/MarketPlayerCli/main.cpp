@@ -0,0 +1,304 @@
+#include <QCoreApplication>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+
+#include <iostream>
+#include <thread>
+
+#include "model.h"
+#include "goodseconomy.h"
+#include "strategymapper.h"
+#include "simulationconfig.h"
+#include "checkpoint.h"
+#include "historywriter.h"
+#include "sweep.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace {
+
+void printUsage()
+{
+    cerr << "Usage: marketplayer-cli <configuration.ini> <output.csv> [options]" << endl
+         << "       marketplayer-cli --resume <checkpoint.mpc> <output.csv> [options]" << endl
+         << "       marketplayer-cli --sweep <sweep.ini> <results.csv> [--jobs <threads>]" << endl
+         << "       marketplayer-cli --ensemble <runs> <configuration.ini> <bands.csv> [--jobs <threads>]" << endl
+         << "Options:" << endl
+         << "  --checkpoint <checkpoint.mpc>  save the simulation there when it finishes" << endl
+         << "  --checkpoint-interval <rounds> also save it every this many rounds" << endl;
+}
+
+int runEnsembleRuns(QString configFileName, QString bandsFileName, size_t numRuns, size_t numThreads)
+{
+    SimulationConfig config;
+    if (!loadSimulationConfig(configFileName, config)) {
+        cerr << "Could not read configuration file " << configFileName.toStdString() << endl;
+        return 1;
+    }
+    Ensemble ensemble;
+    QElapsedTimer timer;
+    timer.start();
+    if (!runEnsemble(config, 0, numRuns, numThreads, ensemble)) {
+        cerr << "The simulation could not be setup using this configuration file!" << endl;
+        return 1;
+    }
+    qint64 const elapsedMs = timer.elapsed();
+    if (!writeEnsembleBands(bandsFileName, ensemble)) {
+        cerr << "Could not write output file " << bandsFileName.toStdString() << endl;
+        return 1;
+    }
+    cout << "runs: " << ensemble.getNumRuns() << ", rounds: " << ensemble.getNumRounds()
+         << ", threads: " << numThreads << ", elapsed: " << elapsedMs << " ms" << endl;
+    return 0;
+}
+
+const size_t maxNumGoods = 6;
+
+//A configuration of more than two goods, run by GoodsEconomy. It writes the counters of every round
+//as they come, the economy keeps no history. The exponents are equal, the configuration has no others.
+template<size_t NumGoods>
+int runGoodsEconomy(SimulationConfig const& config, QString outputFileName)
+{
+    std::array<Amount_t, NumGoods> amounts;
+    amounts[0] = config.amountQ1;
+    amounts[1] = config.amountQ2;
+    std::copy(config.furtherAmounts.begin(), config.furtherAmounts.end(), amounts.begin() + 2);
+    std::array<double, NumGoods> alfas;
+    alfas.fill(1.0 / NumGoods);
+    GoodsEconomy<NumGoods> economy;
+    if (!economy.setup(config.seed, config.numActors, amounts, alfas, config.minTradeFactor)) {
+        cerr << "The simulation could not be setup using this configuration file!" << endl;
+        return 1;
+    }
+    economy.setNumThreads(config.numThreads);
+    unique_ptr<AbstractStoppingRule> const stoppingRule =
+            createStoppingRule(config.maxRoundWithoutTrade, config.stopping);
+
+    QFile file(outputFileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        cerr << "Could not write output file " << outputFileName.toStdString() << endl;
+        return 1;
+    }
+    QTextStream out(&file);
+    out.setRealNumberPrecision(12);
+    //the columns of writeHistorySeries as far as the economy has them, one traded column per good
+    out << "round";
+    for (size_t goodIdx = 0; goodIdx < NumGoods; ++goodIdx) {
+        out << ",q" << goodIdx + 1 << "_traded";
+    }
+    out << ",num_successful,sum_utilities\n";
+    out << '0';
+    for (size_t goodIdx = 0; goodIdx < NumGoods; ++goodIdx) {
+        out << ",0";
+    }
+    out << ",0," << economy.calculateSumUtilities() << '\n';
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!stoppingRule->isSatisfied()) {
+        QElapsedTimer roundTimer;
+        roundTimer.start();
+        economy.performNextRound();
+        RoundOutcome const outcome = economy.getLastRoundOutcome(roundTimer.nsecsElapsed() * 1e-9);
+        stoppingRule->recordRound(outcome);
+        out << outcome.time;
+        for (Amount_t traded : economy.getLastRoundInfo().traded) {
+            out << ',' << traded;
+        }
+        out << ',' << outcome.numSuccessful << ',' << outcome.sumUtilities << '\n';
+    }
+    qint64 const elapsedMs = timer.elapsed();
+    out.flush();
+    if (file.error() != QFile::NoError) {
+        cerr << "Could not write output file " << outputFileName.toStdString() << endl;
+        return 1;
+    }
+
+    cout << "rounds: " << economy.getNumRounds()
+         << ", actors: " << economy.getNumActors()
+         << ", goods: " << NumGoods
+         << ", elapsed: " << elapsedMs << " ms" << endl;
+    cout << "stopped by: " << stoppingRule->describe() << endl;
+    return 0;
+}
+
+//GoodsEconomy trades by the random pareto offer and the higher gain acceptance only
+int runGoodsEconomyByConfig(SimulationConfig const& config, QString outputFileName)
+{
+    if (config.numGoods < 3 || config.numGoods > maxNumGoods) {
+        cerr << "num_goods must be 2 to " << maxNumGoods << endl;
+        return 1;
+    }
+    for (size_t idx = 0; idx < config.furtherAmounts.size(); ++idx) {
+        if (config.furtherAmounts[idx] == 0) {
+            cerr << "q" << idx + 3 << "_sum must be set for " << config.numGoods << " goods" << endl;
+            return 1;
+        }
+    }
+    if (config.offerStrategy != randomParetoValue || config.acceptanceStrategy != higherGainValue) {
+        cerr << "More than two goods are only traded with the " << randomParetoValue.toStdString()
+             << " offer and the " << higherGainValue.toStdString() << " acceptance" << endl;
+        return 1;
+    }
+    switch (config.numGoods) {
+    case 3: return runGoodsEconomy<3>(config, outputFileName);
+    case 4: return runGoodsEconomy<4>(config, outputFileName);
+    case 5: return runGoodsEconomy<5>(config, outputFileName);
+    default: return runGoodsEconomy<maxNumGoods>(config, outputFileName);
+    }
+}
+
+int runSweepJobs(QString specFileName, QString resultsFileName, size_t numThreads)
+{
+    std::vector<SimulationConfig> jobs;
+    if (!loadSweepJobs(specFileName, jobs)) {
+        cerr << "Could not read sweep file " << specFileName.toStdString() << endl;
+        return 1;
+    }
+    QFile file(resultsFileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        cerr << "Could not write output file " << resultsFileName.toStdString() << endl;
+        return 1;
+    }
+    QTextStream out(&file);
+    out.setRealNumberPrecision(12);
+    writeSweepHeader(out);
+
+    size_t numFinished = 0;
+    size_t numFailed = 0;
+    QElapsedTimer timer;
+    timer.start();
+    runSweep(jobs, numThreads, [&](size_t jobIdx, Simulation const* simulation) {
+        ++numFinished;
+        if (simulation) {
+            writeSweepJob(out, jobIdx, jobs[jobIdx], simulation->history);
+            cout << "job " << jobIdx << " (" << numFinished << "/" << jobs.size() << "): "
+                 << "rounds: " << simulation->history.size() - 1 << endl;
+        } else {
+            ++numFailed;
+            cerr << "job " << jobIdx << " (" << numFinished << "/" << jobs.size() << "): "
+                 << "the simulation could not be setup" << endl;
+        }
+    });
+
+    cout << "jobs: " << jobs.size() << ", failed: " << numFailed
+         << ", threads: " << numThreads << ", elapsed: " << timer.elapsed() << " ms" << endl;
+    if (file.error() != QFile::NoError) {
+        cerr << "Could not write output file " << resultsFileName.toStdString() << endl;
+        return 1;
+    }
+    return numFailed == 0 ? 0 : 1;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList const arguments = app.arguments();
+
+    bool resume = false;
+    bool sweep = false;
+    size_t numEnsembleRuns = 0;
+    size_t numSweepThreads = std::max(1u, std::thread::hardware_concurrency());
+    QStringList fileNames;
+    QString checkpointFileName;
+    size_t checkpointInterval = 0;
+    bool validArguments = true;
+    for (int argIdx = 1; argIdx < arguments.size() && validArguments; ++argIdx) {
+        QString const& argument = arguments[argIdx];
+        bool const hasValue = argIdx + 1 < arguments.size();
+        if (argument == "--resume") {
+            resume = true;
+        } else if (argument == "--sweep") {
+            sweep = true;
+        } else if (argument == "--ensemble" && hasValue) {
+            numEnsembleRuns = arguments[++argIdx].toUInt(&validArguments);
+            validArguments = validArguments && numEnsembleRuns > 0;
+        } else if (argument == "--jobs" && hasValue) {
+            numSweepThreads = arguments[++argIdx].toUInt(&validArguments);
+        } else if (argument == "--checkpoint" && hasValue) {
+            checkpointFileName = arguments[++argIdx];
+        } else if (argument == "--checkpoint-interval" && hasValue) {
+            checkpointInterval = arguments[++argIdx].toUInt(&validArguments);
+        } else if (argument.startsWith("--")) {
+            validArguments = false;
+        } else {
+            fileNames.push_back(argument);
+        }
+    }
+    if (!validArguments || fileNames.size() != 2 ||
+            (checkpointInterval > 0 && checkpointFileName.isEmpty()) ||
+            ((sweep || numEnsembleRuns > 0) && (resume || !checkpointFileName.isEmpty())) ||
+            (sweep && numEnsembleRuns > 0)) {
+        printUsage();
+        return 1;
+    }
+    QString const inputFileName = fileNames[0];
+    QString const outputFileName = fileNames[1];
+    if (sweep) {
+        return runSweepJobs(inputFileName, outputFileName, numSweepThreads);
+    }
+    if (numEnsembleRuns > 0) {
+        return runEnsembleRuns(inputFileName, outputFileName, numEnsembleRuns, numSweepThreads);
+    }
+
+    Simulation simulation;
+    if (resume) {
+        if (!loadCheckpoint(inputFileName, simulation)) {
+            cerr << "The simulation could not be resumed from checkpoint file " << inputFileName.toStdString() << endl;
+            return 1;
+        }
+    } else {
+        SimulationConfig config;
+        if (!loadSimulationConfig(inputFileName, config)) {
+            cerr << "Could not read configuration file " << inputFileName.toStdString() << endl;
+            return 1;
+        }
+        if (config.numGoods != 2) {
+            if (!checkpointFileName.isEmpty()) {
+                cerr << "Checkpoints are of two goods only" << endl;
+                return 1;
+            }
+            return runGoodsEconomyByConfig(config, outputFileName);
+        }
+        if (!setupSimulationByConfig(simulation, config)) {
+            cerr << "The simulation could not be setup using this configuration file!" << endl;
+            return 1;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (simulation.canContinueSimulation()) {
+        simulation.performNextRound();
+        if (checkpointInterval > 0 && simulation.history.size() % checkpointInterval == 0 &&
+                !saveCheckpoint(checkpointFileName, simulation)) {
+            cerr << "Could not write checkpoint file " << checkpointFileName.toStdString() << endl;
+            return 1;
+        }
+    }
+    qint64 const elapsedMs = timer.elapsed();
+
+    if (!checkpointFileName.isEmpty() && !saveCheckpoint(checkpointFileName, simulation)) {
+        cerr << "Could not write checkpoint file " << checkpointFileName.toStdString() << endl;
+        return 1;
+    }
+
+    if (!writeHistorySeries(outputFileName, simulation.history)) {
+        cerr << "Could not write output file " << outputFileName.toStdString() << endl;
+        return 1;
+    }
+
+    cout << "rounds: " << simulation.history.size() - 1
+         << ", actors: " << simulation.numActors
+         << ", elapsed: " << elapsedMs << " ms" << endl;
+    if (simulation.getStoppingRule()) {
+        cout << "stopped by: " << simulation.getStoppingRule()->describe() << endl;
+    }
+    return 0;
+}